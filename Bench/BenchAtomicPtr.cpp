@@ -0,0 +1,129 @@
+//================================================================================================
+// Atomic pointer benchmarks
+//
+// Read-mostly publication of a shared object: every thread loads the current object, and
+// thread 0 also replaces it once every WriteInterval iterations. TAtomicGemPtr is compared
+// with a TGemPtr guarded by std::mutex and by std::shared_mutex.
+//================================================================================================
+
+#include "BenchHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemAtomicPtr.hpp>
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace GemBench
+{
+constexpr uint64_t WriteInterval = 1024;
+
+struct XRoutingTable : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XRoutingTable, 0x58E1C07A3F92B46D);
+
+    GEMMETHOD_(int, Route)(int key) = 0;
+};
+
+class CRoutingTable : public Gem::TGeneric<XRoutingTable>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XRoutingTable)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) Route(int key) override { return key + 1; }
+};
+
+// Two tables the writer alternates between, so writes measure publication rather than creation
+struct Tables
+{
+    Gem::TGemPtr<CRoutingTable> pTables[2];
+
+    Tables()
+    {
+        Gem::TGenericImpl<CRoutingTable>::Create(&pTables[0]);
+        Gem::TGenericImpl<CRoutingTable>::Create(&pTables[1]);
+    }
+
+    XRoutingTable *Next(uint64_t i) const
+    {
+        return pTables[(i / WriteInterval) & 1].Get();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(AtomicPtrReadMostly)
+{
+    Tables tables;
+
+    Gem::TAtomicGemPtr<XRoutingTable> atomicTable(tables.Next(0));
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("AtomicPtr/ReadMostly/TAtomicGemPtr", threads, [&](unsigned threadIndex, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                if (threadIndex == 0 && i % WriteInterval == 0)
+                {
+                    atomicTable.Store(tables.Next(i));
+                }
+
+                Gem::TGemPtr<XRoutingTable> pTable = atomicTable.Load();
+                DoNotOptimize(pTable->Route(static_cast<int>(i)));
+            }
+        });
+    }
+
+    std::mutex mutex;
+    Gem::TGemPtr<XRoutingTable> pMutexTable = tables.Next(0);
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("AtomicPtr/ReadMostly/Mutex", threads, [&](unsigned threadIndex, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                if (threadIndex == 0 && i % WriteInterval == 0)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pMutexTable = tables.Next(i);
+                }
+
+                Gem::TGemPtr<XRoutingTable> pTable;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    pTable = pMutexTable;
+                }
+                DoNotOptimize(pTable->Route(static_cast<int>(i)));
+            }
+        });
+    }
+
+    std::shared_mutex sharedMutex;
+    Gem::TGemPtr<XRoutingTable> pSharedTable = tables.Next(0);
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("AtomicPtr/ReadMostly/SharedMutex", threads, [&](unsigned threadIndex, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                if (threadIndex == 0 && i % WriteInterval == 0)
+                {
+                    std::unique_lock<std::shared_mutex> lock(sharedMutex);
+                    pSharedTable = tables.Next(i);
+                }
+
+                Gem::TGemPtr<XRoutingTable> pTable;
+                {
+                    std::shared_lock<std::shared_mutex> lock(sharedMutex);
+                    pTable = pSharedTable;
+                }
+                DoNotOptimize(pTable->Route(static_cast<int>(i)));
+            }
+        });
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+//================================================================================================
+// Class registry benchmarks
+//
+// Create by class id through Gem::CreateInstance compared with a direct TGenericImpl::Create,
+// with the registry still open (locked search) and after ClassRegistry::Freeze (perfect hash).
+// The registry holds SyntheticClassCount classes besides the one being created.
+//================================================================================================
+
+#include "BenchHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemClassFactory.hpp>
+
+#include <cstdint>
+#include <utility>
+
+namespace GemBench
+{
+constexpr size_t SyntheticClassCount = 256;
+
+struct XService : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XService, 0x6C1F9A4E27D3B805);
+
+    GEMMETHOD_(int, Value)() = 0;
+};
+
+template<size_t _Index>
+class CService : public Gem::TGeneric<XService>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XService)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) Value() override { return static_cast<int>(_Index); }
+};
+
+constexpr uint64_t ServiceClassId(size_t index)
+{
+    return Gem::HashInterfaceName("GemBench::CService") + index;
+}
+
+using CTargetService = CService<SyntheticClassCount>;
+GEM_REGISTER_CLASS(ServiceClassId(SyntheticClassCount), CTargetService);
+
+template<size_t... _Indices>
+void RegisterSyntheticClasses(std::index_sequence<_Indices...>)
+{
+    (Gem::ClassRegistry::Register(ServiceClassId(_Indices), &Gem::TClassFactory<CService<_Indices>>::Instance()), ...);
+}
+
+void CreateByIdRelease(uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        XService *pObj = nullptr;
+        Gem::CreateInstance(ServiceClassId(SyntheticClassCount), XService::IId, reinterpret_cast<void **>(&pObj));
+        GemBench::DoNotOptimize(pObj);
+        pObj->Release();
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(ClassRegistry)
+{
+    RegisterSyntheticClasses(std::make_index_sequence<SyntheticClassCount>());
+
+    runner.Run("CreateInstance/Direct", [](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CTargetService *pObj = nullptr;
+            Gem::TGenericImpl<CTargetService>::Create(&pObj);
+            GemBench::DoNotOptimize(pObj);
+            pObj->Release();
+        }
+    });
+
+    runner.Run("CreateInstance/Open", [](unsigned, uint64_t iterations)
+    {
+        CreateByIdRelease(iterations);
+    });
+
+    Gem::ClassRegistry::Freeze();
+
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("CreateInstance/Frozen", threads, [](unsigned, uint64_t iterations)
+        {
+            CreateByIdRelease(iterations);
+        });
+    }
+}
+
+}
@@ -0,0 +1,229 @@
+//================================================================================================
+// Object creation benchmarks
+//
+// - Create + final Release throughput for the global heap, GEM_POOLED_ALLOCATION, and
+//   CreateWith on std::pmr memory resources
+// - Create of a class whose Initialize returns a Result instead of throwing
+// - Create with heavyweight constructor arguments, copied or moved into the object
+//================================================================================================
+
+#include "BenchHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemPool.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GemBench
+{
+struct XWidget : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XWidget, 0x2D8E4A1F6B39C057);
+
+    GEMMETHOD_(int, Value)() = 0;
+};
+
+class CWidget : public Gem::TGeneric<XWidget>
+{
+    int m_value = 0;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XWidget)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() { m_value = 1; }
+
+    GEMMETHODIMP_(int) Value() override { return m_value; }
+};
+
+class CPooledWidget : public CWidget
+{
+public:
+    GEM_POOLED_ALLOCATION(CPooledWidget)
+};
+
+// Reports initialization failure through its return value rather than by throwing GemError
+class CResultWidget : public Gem::TGeneric<XWidget>
+{
+    int m_value = 0;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XWidget)
+    END_GEM_INTERFACE_MAP()
+
+    Gem::Result Initialize()
+    {
+        m_value = 1;
+        return Gem::Result::Success;
+    }
+
+    GEMMETHODIMP_(int) Value() override { return m_value; }
+};
+
+// Built from a name and a payload buffer, which it can hand back so a benchmark can reuse it
+class CDocument : public Gem::TGeneric<XWidget>
+{
+    std::string m_name;
+    std::vector<uint8_t> m_payload;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XWidget)
+    END_GEM_INTERFACE_MAP()
+
+    CDocument(std::string name, std::vector<uint8_t> payload) :
+        m_name(std::move(name)),
+        m_payload(std::move(payload))
+    {
+    }
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) Value() override { return static_cast<int>(m_payload.size()); }
+
+    std::vector<uint8_t> TakePayload() { return std::move(m_payload); }
+};
+
+class CBufferOwner : public Gem::TGeneric<XWidget>
+{
+    std::unique_ptr<std::vector<uint8_t>> m_pBuffer;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XWidget)
+    END_GEM_INTERFACE_MAP()
+
+    explicit CBufferOwner(std::unique_ptr<std::vector<uint8_t>> pBuffer) :
+        m_pBuffer(std::move(pBuffer))
+    {
+    }
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) Value() override { return static_cast<int>(m_pBuffer->size()); }
+
+    std::unique_ptr<std::vector<uint8_t>> TakeBuffer() { return std::move(m_pBuffer); }
+};
+
+constexpr size_t PayloadSize = 64 * 1024;
+
+template<class _Class>
+void CreateRelease(uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        _Class *pObj = nullptr;
+        Gem::TGenericImpl<_Class>::Create(&pObj);
+        GemBench::DoNotOptimize(pObj);
+        pObj->Release();
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(CreateThroughput)
+{
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("Create/GlobalHeap", threads, [](unsigned, uint64_t iterations)
+        {
+            CreateRelease<CWidget>(iterations);
+        });
+
+        runner.Run("Create/Pooled", threads, [](unsigned, uint64_t iterations)
+        {
+            CreateRelease<CPooledWidget>(iterations);
+        });
+
+        runner.Run("Create/ResultInitialize", threads, [](unsigned, uint64_t iterations)
+        {
+            CreateRelease<CResultWidget>(iterations);
+        });
+    }
+
+    runner.Run("Create/MonotonicResource", [](unsigned, uint64_t iterations)
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CWidget *pObj = nullptr;
+            Gem::TGenericImpl<CWidget>::CreateWith(&arena, &pObj);
+            GemBench::DoNotOptimize(pObj);
+            pObj->Release();
+
+            // Reclaim in bulk every so often, as a per-frame arena would
+            if ((i & 4095) == 4095)
+            {
+                arena.release();
+            }
+        }
+    });
+
+    runner.Run("Create/UnsynchronizedPoolResource", [](unsigned, uint64_t iterations)
+    {
+        std::pmr::unsynchronized_pool_resource pool;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CWidget *pObj = nullptr;
+            Gem::TGenericImpl<CWidget>::CreateWith(&pool, &pObj);
+            GemBench::DoNotOptimize(pObj);
+            pObj->Release();
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(CreateWithArguments)
+{
+    const std::string name(256, 'n');
+
+    // One deep copy of the arguments into the object
+    runner.Run("Create/Arguments/Copied", [&](unsigned, uint64_t iterations)
+    {
+        std::vector<uint8_t> payload(PayloadSize, 1);
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CDocument *pObj = nullptr;
+            Gem::TGenericImpl<CDocument>::Create(&pObj, name, payload);
+            GemBench::DoNotOptimize(pObj);
+            pObj->Release();
+        }
+    });
+
+    // Forwarded as rvalues all the way to the members; only the short name is re-copied
+    runner.Run("Create/Arguments/Moved", [&](unsigned, uint64_t iterations)
+    {
+        std::string movedName = name;
+        std::vector<uint8_t> payload(PayloadSize, 1);
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CDocument *pObj = nullptr;
+            Gem::TGenericImpl<CDocument>::Create(&pObj, std::move(movedName), std::move(payload));
+            GemBench::DoNotOptimize(pObj);
+            payload = pObj->TakePayload();
+            movedName = name;
+            pObj->Release();
+        }
+    });
+
+    runner.Run("Create/Arguments/MoveOnly", [&](unsigned, uint64_t iterations)
+    {
+        auto pBuffer = std::make_unique<std::vector<uint8_t>>(PayloadSize, 1);
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CBufferOwner *pObj = nullptr;
+            Gem::TGenericImpl<CBufferOwner>::Create(&pObj, std::move(pBuffer));
+            GemBench::DoNotOptimize(pObj);
+            pBuffer = pObj->TakeBuffer();
+            pObj->Release();
+        }
+    });
+}
+
+}
@@ -0,0 +1,120 @@
+//================================================================================================
+// Epoch-based deferred release benchmarks
+//
+// - Walking a shared list with a TGemPtr per hop (AddRef and Release on every node) versus raw
+//   pointers inside an EpochReadGuard
+// - Retiring through GemRetire versus releasing immediately
+//================================================================================================
+
+#include "BenchHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemEpoch.hpp>
+
+namespace GemBench
+{
+constexpr int ListLength = 64;
+
+struct XListNode : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XListNode, 0x3C7A19E52F80D46B);
+
+    GEMMETHOD_(XListNode *, Next)() = 0;
+    GEMMETHOD_(int, Value)() = 0;
+};
+
+class CListNode : public Gem::TGeneric<XListNode>
+{
+    Gem::TGemPtr<XListNode> m_pNext;
+    int m_value = 0;
+
+public:
+    CListNode(XListNode *pNext = nullptr) :
+        m_pNext(pNext)
+    {
+    }
+
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XListNode)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() { m_value = 1; }
+
+    GEMMETHODIMP_(XListNode *) Next() override { return m_pNext.Get(); }
+    GEMMETHODIMP_(int) Value() override { return m_value; }
+};
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(EpochTraversal)
+{
+    Gem::TGemPtr<XListNode> pHead;
+    for (int i = 0; i < ListLength; ++i)
+    {
+        Gem::TGemPtr<CListNode> pNode;
+        Gem::TGenericImpl<CListNode>::Create(&pNode, pHead.Get());
+        pHead = pNode.Get();
+    }
+
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("Epoch/Traverse/RefCounted", threads, [&](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                int sum = 0;
+                for (Gem::TGemPtr<XListNode> pNode = pHead; pNode; pNode = pNode->Next())
+                {
+                    sum += pNode->Value();
+                }
+                DoNotOptimize(sum);
+            }
+        });
+
+        runner.Run("Epoch/Traverse/ReadGuard", threads, [&](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                Gem::EpochReadGuard guard;
+                int sum = 0;
+                for (XListNode *pNode = pHead.Get(); pNode; pNode = pNode->Next())
+                {
+                    sum += pNode->Value();
+                }
+                DoNotOptimize(sum);
+            }
+        });
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(EpochRetire)
+{
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("Epoch/Retire/Release", threads, [](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                CListNode *pNode = nullptr;
+                Gem::TGenericImpl<CListNode>::Create(&pNode);
+                DoNotOptimize(pNode);
+                pNode->Release();
+            }
+        });
+
+        runner.Run("Epoch/Retire/GemRetire", threads, [](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                CListNode *pNode = nullptr;
+                Gem::TGenericImpl<CListNode>::Create(&pNode);
+                DoNotOptimize(pNode);
+                Gem::GemRetire(pNode);
+            }
+
+            Gem::GemSynchronize();
+        });
+    }
+}
+
+}
@@ -0,0 +1,327 @@
+#include "BenchHarness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+namespace GemBench
+{
+namespace
+{
+struct RegisteredGroup
+{
+    const char *Name;
+    BenchmarkGroup Group;
+};
+
+std::vector<RegisteredGroup> &Groups()
+{
+    static std::vector<RegisteredGroup> groups;
+    return groups;
+}
+
+using Clock = std::chrono::steady_clock;
+
+//------------------------------------------------------------------------------------------------
+std::string JsonEscape(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+//------------------------------------------------------------------------------------------------
+void WriteConsole(FILE *pFile, const std::vector<Measurement> &results)
+{
+    fprintf(pFile, "%-56s %8s %14s %12s %14s\n", "Benchmark", "Threads", "Iterations", "ns/op", "Mops/s");
+    for (const Measurement &m : results)
+    {
+        fprintf(pFile, "%-56s %8u %14llu %12.2f %14.2f\n", m.Name.c_str(), m.Threads,
+            static_cast<unsigned long long>(m.Iterations), m.NsPerOp, m.OpsPerSec / 1e6);
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+void WriteCsv(FILE *pFile, const std::vector<Measurement> &results)
+{
+    fprintf(pFile, "name,threads,iterations,ns_per_op,ops_per_sec\n");
+    for (const Measurement &m : results)
+    {
+        fprintf(pFile, "%s,%u,%llu,%.3f,%.1f\n", m.Name.c_str(), m.Threads,
+            static_cast<unsigned long long>(m.Iterations), m.NsPerOp, m.OpsPerSec);
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+void WriteJson(FILE *pFile, const std::vector<Measurement> &results)
+{
+    char timestamp[32] = {};
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    fprintf(pFile, "{\n");
+    fprintf(pFile, "  \"context\": {\n");
+    fprintf(pFile, "    \"timestamp\": \"%s\",\n", timestamp);
+    fprintf(pFile, "    \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency());
+#if defined(__clang__)
+    fprintf(pFile, "    \"compiler\": \"clang %s\"\n", __clang_version__);
+#elif defined(__GNUC__)
+    fprintf(pFile, "    \"compiler\": \"gcc %s\"\n", __VERSION__);
+#elif defined(_MSC_VER)
+    fprintf(pFile, "    \"compiler\": \"msvc %d\"\n", _MSC_VER);
+#else
+    fprintf(pFile, "    \"compiler\": \"unknown\"\n");
+#endif
+    fprintf(pFile, "  },\n");
+    fprintf(pFile, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Measurement &m = results[i];
+        fprintf(pFile, "    {\"name\": \"%s\", \"threads\": %u, \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f}%s\n",
+            JsonEscape(m.Name).c_str(), m.Threads, static_cast<unsigned long long>(m.Iterations),
+            m.NsPerOp, m.OpsPerSec, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(pFile, "  ]\n");
+    fprintf(pFile, "}\n");
+}
+
+//------------------------------------------------------------------------------------------------
+std::vector<unsigned> ParseThreadCounts(const char *pList)
+{
+    std::vector<unsigned> counts;
+    while (*pList)
+    {
+        char *pEnd = nullptr;
+        unsigned long count = std::strtoul(pList, &pEnd, 10);
+        if (pEnd == pList)
+        {
+            break;
+        }
+        if (count > 0)
+        {
+            counts.push_back(static_cast<unsigned>(count));
+        }
+        pList = *pEnd == ',' ? pEnd + 1 : pEnd;
+    }
+
+    return counts;
+}
+
+//------------------------------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf(
+        "Usage: GemBench [options]\n"
+        "  --filter=TEXT        Run only measurements whose name contains TEXT\n"
+        "  --format=FORMAT      console (default), csv or json\n"
+        "  --out=FILE           Write results to FILE instead of stdout\n"
+        "  --min-time=SECONDS   Minimum time per repetition (default 0.2)\n"
+        "  --repetitions=N      Repetitions per measurement; the median is reported (default 3)\n"
+        "  --threads=LIST       Comma-separated thread counts for scaling runs (default 1,4,16)\n"
+        "  --list               List benchmark groups\n");
+}
+}
+
+//------------------------------------------------------------------------------------------------
+Registration::Registration(const char *name, BenchmarkGroup group)
+{
+    Groups().push_back({name, group});
+}
+
+//------------------------------------------------------------------------------------------------
+bool Runner::Enabled(const std::string &name) const
+{
+    return m_Options.Filter.empty() || name.find(m_Options.Filter) != std::string::npos;
+}
+
+//------------------------------------------------------------------------------------------------
+double Runner::Measure(unsigned threads, uint64_t iterations, const Body &body)
+{
+    if (threads == 1)
+    {
+        auto start = Clock::now();
+        body(0, iterations);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Threads are created before the clock starts and released together
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (unsigned index = 0; index < threads; ++index)
+    {
+        workers.emplace_back([&, index]
+        {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            body(index, iterations);
+        });
+    }
+
+    while (ready.load() != threads)
+    {
+        std::this_thread::yield();
+    }
+
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------------------------------
+void Runner::Run(const std::string &name, unsigned threads, const Body &body)
+{
+    if (!Enabled(name))
+    {
+        return;
+    }
+
+    // Grow the iteration count until one run takes at least the minimum time
+    uint64_t iterations = 16;
+    for (;;)
+    {
+        double seconds = Measure(threads, iterations, body);
+        if (seconds >= m_Options.MinTimeSec || iterations >= (uint64_t(1) << 34))
+        {
+            break;
+        }
+
+        double scale = seconds > 0 ? 1.4 * m_Options.MinTimeSec / seconds : 10.0;
+        iterations = static_cast<uint64_t>(static_cast<double>(iterations) * std::min(std::max(scale, 2.0), 10.0));
+    }
+
+    std::vector<double> samples;
+    for (unsigned repetition = 0; repetition < std::max(m_Options.Repetitions, 1u); ++repetition)
+    {
+        samples.push_back(Measure(threads, iterations, body));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+
+    Measurement m;
+    m.Name = name;
+    m.Threads = threads;
+    m.Iterations = iterations;
+    m.NsPerOp = median * 1e9 / static_cast<double>(iterations);
+    m.OpsPerSec = static_cast<double>(iterations) * threads / median;
+    m_Results.push_back(m);
+
+    fprintf(stderr, "%-56s %3u thread(s) %10.2f ns/op\n", name.c_str(), threads, m.NsPerOp);
+}
+
+}
+
+//------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    GemBench::Runner::Options options;
+    std::string format = "console";
+    std::string outPath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *pArg = argv[i];
+        if (strncmp(pArg, "--filter=", 9) == 0)
+        {
+            options.Filter = pArg + 9;
+        }
+        else if (strncmp(pArg, "--format=", 9) == 0)
+        {
+            format = pArg + 9;
+        }
+        else if (strncmp(pArg, "--out=", 6) == 0)
+        {
+            outPath = pArg + 6;
+        }
+        else if (strncmp(pArg, "--min-time=", 11) == 0)
+        {
+            options.MinTimeSec = std::atof(pArg + 11);
+        }
+        else if (strncmp(pArg, "--repetitions=", 14) == 0)
+        {
+            options.Repetitions = static_cast<unsigned>(std::atoi(pArg + 14));
+        }
+        else if (strncmp(pArg, "--threads=", 10) == 0)
+        {
+            options.ThreadCounts = GemBench::ParseThreadCounts(pArg + 10);
+        }
+        else if (strcmp(pArg, "--list") == 0)
+        {
+            for (const GemBench::RegisteredGroup &group : GemBench::Groups())
+            {
+                printf("%s\n", group.Name);
+            }
+            return 0;
+        }
+        else
+        {
+            GemBench::PrintUsage();
+            return strcmp(pArg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (format != "console" && format != "csv" && format != "json")
+    {
+        GemBench::PrintUsage();
+        return 1;
+    }
+
+    GemBench::Runner runner(options);
+    for (const GemBench::RegisteredGroup &group : GemBench::Groups())
+    {
+        group.Group(runner);
+    }
+
+    FILE *pFile = stdout;
+    if (!outPath.empty())
+    {
+        pFile = fopen(outPath.c_str(), "w");
+        if (!pFile)
+        {
+            fprintf(stderr, "Cannot open %s\n", outPath.c_str());
+            return 1;
+        }
+    }
+
+    if (format == "json")
+    {
+        GemBench::WriteJson(pFile, runner.Results());
+    }
+    else if (format == "csv")
+    {
+        GemBench::WriteCsv(pFile, runner.Results());
+    }
+    else
+    {
+        GemBench::WriteConsole(pFile, runner.Results());
+    }
+
+    if (pFile != stdout)
+    {
+        fclose(pFile);
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+//================================================================================================
+// GeM benchmark harness
+//
+// Minimal self-contained timing harness for the GeM primitives:
+// - Benchmarks are grouped in functions registered with GEM_BENCHMARK_GROUP
+// - Each measurement auto-calibrates its iteration count, then reports the median
+//   of several repetitions
+// - Multi-threaded measurements start all threads together and report both per-thread
+//   latency and aggregate throughput
+// - Results can be written as console text, CSV, or JSON for tracking across releases
+//================================================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace GemBench
+{
+//------------------------------------------------------------------------------------------------
+// Keeps value (and everything it points to) alive as far as the optimizer is concerned
+template<class _Type>
+inline void DoNotOptimize(_Type const &value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static volatile const void *s_pSink;
+    s_pSink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+//------------------------------------------------------------------------------------------------
+struct Measurement
+{
+    std::string Name;
+    unsigned Threads = 1;
+    uint64_t Iterations = 0;    // Per thread
+    double NsPerOp = 0;         // Per-thread latency
+    double OpsPerSec = 0;       // Aggregate throughput across all threads
+};
+
+//------------------------------------------------------------------------------------------------
+class Runner
+{
+public:
+    // Runs `iterations` operations on thread `threadIndex`
+    using Body = std::function<void(unsigned threadIndex, uint64_t iterations)>;
+
+    struct Options
+    {
+        std::string Filter;
+        double MinTimeSec = 0.2;
+        unsigned Repetitions = 3;
+        std::vector<unsigned> ThreadCounts{1, 4, 16};
+    };
+
+    explicit Runner(const Options &options) :
+        m_Options(options) {}
+
+    // True if a measurement with this name would run; lets groups skip expensive setup
+    bool Enabled(const std::string &name) const;
+
+    void Run(const std::string &name, unsigned threads, const Body &body);
+
+    void Run(const std::string &name, const Body &body)
+    {
+        Run(name, 1, body);
+    }
+
+    const std::vector<unsigned> &ThreadCounts() const { return m_Options.ThreadCounts; }
+    const std::vector<Measurement> &Results() const { return m_Results; }
+
+private:
+    double Measure(unsigned threads, uint64_t iterations, const Body &body);
+
+    Options m_Options;
+    std::vector<Measurement> m_Results;
+};
+
+//------------------------------------------------------------------------------------------------
+using BenchmarkGroup = void (*)(Runner &);
+
+struct Registration
+{
+    Registration(const char *name, BenchmarkGroup group);
+};
+
+}
+
+// Defines and registers a group of related measurements
+#define GEM_BENCHMARK_GROUP(name) \
+    static void name(GemBench::Runner &runner); \
+    static GemBench::Registration s_##name##Registration(#name, name); \
+    static void name(GemBench::Runner &runner)
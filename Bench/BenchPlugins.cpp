@@ -0,0 +1,180 @@
+//================================================================================================
+// Plugin module benchmarks
+//
+// - CreateInstance of a class provided by an already loaded plugin module
+// - The first CreateInstance after the module was unloaded: dlopen, entry point lookup and
+//   creation, followed by UnloadUnusedModules
+// - Learning which classes every module provides: mapping a manifest and checking each module's
+//   time and size, compared with loading every module to read its class map
+// - Startup: loading and initializing every module with PluginLoader::WarmUp on one thread and
+//   on a pool, respecting the modules' required classes
+//
+// The synthetic modules are built from Plugins/BenchPlugin.cpp and registered during static
+// initialization, before anything can freeze the ClassRegistry.
+//================================================================================================
+
+#include "BenchHarness.hpp"
+#include "Plugins/BenchPlugin.hpp"
+
+#include <Gem.hpp>
+#include <GemPlugin.hpp>
+#include <GemPluginManifest.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace GemBench
+{
+std::string BenchPluginPath(unsigned index)
+{
+    return std::string(GEM_BENCH_PLUGIN_DIR "/GemBenchPlugin") + std::to_string(index) + GEM_BENCH_PLUGIN_SUFFIX;
+}
+
+Gem::Result RegisterBenchPlugins()
+{
+    for (unsigned index = 0; index < GEM_BENCH_PLUGIN_COUNT; ++index)
+    {
+        Gem::PluginLoader::Module *pModule = nullptr;
+        Gem::Result result = Gem::PluginLoader::RegisterModule(BenchPluginPath(index).c_str(), {BenchPluginClassId(index)}, &pModule);
+        if (Gem::Failed(result))
+        {
+            return result;
+        }
+
+        if (index > 0)
+        {
+            pModule->AddRequiredClass(BenchPluginClassId((index - 1) / 2));
+        }
+    }
+
+    return Gem::Result::Success;
+}
+
+static const Gem::Result s_PluginsRegistered = RegisterBenchPlugins();
+
+Gem::Result CreatePluginService(unsigned index)
+{
+    XPluginService *pObj = nullptr;
+    Gem::Result result = Gem::CreateInstance(BenchPluginClassId(index), GEM_IID_PPV_ARGS(&pObj));
+    if (Gem::Succeeded(result))
+    {
+        GemBench::DoNotOptimize(pObj->ModuleIndex());
+        pObj->Release();
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(Plugins)
+{
+    Gem::Result result = Gem::Failed(s_PluginsRegistered) ? s_PluginsRegistered : CreatePluginService(0);
+    if (Gem::Failed(result))
+    {
+        std::fprintf(stderr, "Plugins: cannot create from %s: %s\n", BenchPluginPath(0).c_str(), Gem::GemResultString(result));
+        return;
+    }
+
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("Plugin/CreateInstance", threads, [](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                CreatePluginService(0);
+            }
+        });
+    }
+
+    runner.Run("Plugin/LoadCreateUnload", [](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            CreatePluginService(0);
+            Gem::PluginLoader::UnloadUnusedModules();
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(PluginManifest)
+{
+    std::string manifestPath = (std::filesystem::temp_directory_path() / "GemBenchPlugins.manifest").string();
+
+    Gem::PluginManifestBuilder builder;
+    for (unsigned index = 0; index < GEM_BENCH_PLUGIN_COUNT; ++index)
+    {
+        builder.AddModule(BenchPluginPath(index).c_str());
+    }
+
+    Gem::Result result = builder.Write(manifestPath.c_str());
+    if (Gem::Failed(result))
+    {
+        std::fprintf(stderr, "PluginManifest: cannot write %s: %s\n", manifestPath.c_str(), Gem::GemResultString(result));
+        return;
+    }
+
+    runner.Run("PluginManifest/OpenAndCheck", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::PluginManifest manifest;
+            manifest.Open(manifestPath.c_str());
+            for (const Gem::PluginManifestModule &module : manifest.Modules())
+            {
+                GemBench::DoNotOptimize(manifest.IsCurrent(module));
+                GemBench::DoNotOptimize(manifest.Classes(module).begin()->ClassId);
+            }
+        }
+    });
+
+    runner.Run("PluginManifest/ScanModules", [](unsigned, uint64_t iterations)
+    {
+        std::vector<Gem::PluginLoader::ScannedClass> classes;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            for (unsigned index = 0; index < GEM_BENCH_PLUGIN_COUNT; ++index)
+            {
+                Gem::PluginLoader::ScanModule(BenchPluginPath(index).c_str(), classes);
+                GemBench::DoNotOptimize(classes.front().ClassId);
+            }
+        }
+    });
+
+    std::error_code error;
+    std::filesystem::remove(manifestPath, error);
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(PluginStartup)
+{
+    if (Gem::Failed(s_PluginsRegistered))
+    {
+        return;
+    }
+
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("PluginStartup/WarmUp/" + std::to_string(threads) + "t", [threads](unsigned, uint64_t iterations)
+        {
+            std::vector<Gem::PluginLoader::ModuleLoadResult> results;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                results.clear();
+                if (Gem::Failed(Gem::PluginLoader::WarmUp(threads, &results)))
+                {
+                    for (const Gem::PluginLoader::ModuleLoadResult &moduleResult : results)
+                    {
+                        std::fprintf(stderr, "PluginStartup: %s: %s\n", moduleResult.pModule->Path().c_str(), Gem::GemResultString(moduleResult.Result));
+                    }
+                }
+
+                Gem::PluginLoader::UnloadUnusedModules();
+            }
+        });
+    }
+}
+
+}
@@ -0,0 +1,290 @@
+//================================================================================================
+// QueryInterface benchmarks
+//
+// - Hit and miss cost of BEGIN/END_GEM_INTERFACE_MAP versus GEM_INTERFACE_TABLE by map size
+// - Owning versus borrowed queries, and TQueryCache
+// - Queries and reference counts delegated from TAggregate, TEmbeddedAggregate and
+//   TLazyAggregate inner objects to their outer object
+//================================================================================================
+
+#include "BenchHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <string>
+#include <utility>
+
+namespace GemBench
+{
+constexpr uint64_t ChainIId(int index)
+{
+    return 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(index);
+}
+
+constexpr uint64_t MissingIId = 0x0123456789ABCDEFULL;
+
+// Single-inheritance chain of N interfaces, so one class can implement any number of them
+template<int _Index>
+struct XBenchChain : public XBenchChain<_Index - 1>
+{
+    GEM_INTERFACE_DECLARE(XBenchChain, ChainIId(_Index));
+};
+
+template<>
+struct XBenchChain<1> : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XBenchChain, ChainIId(1));
+};
+
+//------------------------------------------------------------------------------------------------
+// Switch-based interface maps; the entries have to be spelled out
+template<int _Count>
+class CSwitchMap;
+
+#define BENCH_ENTRIES_8(base) \
+    GEM_INTERFACE_ENTRY(XBenchChain<base + 1>) GEM_INTERFACE_ENTRY(XBenchChain<base + 2>) \
+    GEM_INTERFACE_ENTRY(XBenchChain<base + 3>) GEM_INTERFACE_ENTRY(XBenchChain<base + 4>) \
+    GEM_INTERFACE_ENTRY(XBenchChain<base + 5>) GEM_INTERFACE_ENTRY(XBenchChain<base + 6>) \
+    GEM_INTERFACE_ENTRY(XBenchChain<base + 7>) GEM_INTERFACE_ENTRY(XBenchChain<base + 8>)
+#define BENCH_ENTRIES_32(base) \
+    BENCH_ENTRIES_8(base) BENCH_ENTRIES_8(base + 8) BENCH_ENTRIES_8(base + 16) BENCH_ENTRIES_8(base + 24)
+#define BENCH_ENTRIES_128(base) \
+    BENCH_ENTRIES_32(base) BENCH_ENTRIES_32(base + 32) BENCH_ENTRIES_32(base + 64) BENCH_ENTRIES_32(base + 96)
+
+#define BENCH_SWITCH_MAP(count, entries) \
+    template<> \
+    class CSwitchMap<count> : public Gem::TGeneric<XBenchChain<count>> \
+    { \
+    public: \
+        BEGIN_GEM_INTERFACE_MAP() \
+            entries \
+        END_GEM_INTERFACE_MAP() \
+        void Initialize() {} \
+    };
+
+BENCH_SWITCH_MAP(1, GEM_INTERFACE_ENTRY(XBenchChain<1>))
+BENCH_SWITCH_MAP(8, BENCH_ENTRIES_8(0))
+BENCH_SWITCH_MAP(32, BENCH_ENTRIES_32(0))
+BENCH_SWITCH_MAP(128, BENCH_ENTRIES_128(0))
+
+//------------------------------------------------------------------------------------------------
+// Table-based interface maps built from an index sequence
+template<int... _Indices>
+class CTableMapImpl : public Gem::TGeneric<XBenchChain<sizeof...(_Indices)>>
+{
+public:
+    GEM_INTERFACE_TABLE(XBenchChain<_Indices + 1>...)
+
+    void Initialize() {}
+};
+
+template<class _Sequence>
+struct TTableMapFor;
+
+template<int... _Indices>
+struct TTableMapFor<std::integer_sequence<int, _Indices...>>
+{
+    using Type = CTableMapImpl<_Indices...>;
+};
+
+template<int _Count>
+using CTableMap = typename TTableMapFor<std::make_integer_sequence<int, _Count>>::Type;
+
+//------------------------------------------------------------------------------------------------
+template<class _Class, int _Count>
+void RunMapSize(GemBench::Runner &runner, const char *mapKind)
+{
+    std::string prefix = std::string("QueryInterface/") + mapKind + "/" + std::to_string(_Count);
+
+    Gem::TGemPtr<_Class> pObj;
+    Gem::TGenericImpl<_Class>::Create(&pObj);
+    Gem::XGeneric *pGeneric = pObj->template TryAs<Gem::XGeneric>();
+
+    // Cycle through every interface so the compiler cannot specialize on one IId
+    uint64_t iids[_Count];
+    for (int i = 0; i < _Count; ++i)
+    {
+        iids[i] = ChainIId(i + 1);
+    }
+
+    runner.Run(prefix + "/Hit", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            void *pFound = nullptr;
+            pGeneric->QueryInterface(iids[i & (_Count - 1)], &pFound);
+            GemBench::DoNotOptimize(pFound);
+            static_cast<Gem::XGeneric *>(pFound)->Release();
+        }
+    });
+
+    runner.Run(prefix + "/HitBorrowed", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            void *pFound = nullptr;
+            pGeneric->QueryInterfaceBorrowed(iids[i & (_Count - 1)], &pFound);
+            GemBench::DoNotOptimize(pFound);
+        }
+    });
+
+    runner.Run(prefix + "/Miss", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            void *pFound = nullptr;
+            pGeneric->QueryInterface(MissingIId + (i & 1), &pFound);
+            GemBench::DoNotOptimize(pFound);
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------------
+// Aggregation
+struct XOuter : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XOuter, 0x4F2B8C61D03A97E5);
+};
+
+struct XInner : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XInner, 0x7A15E3C92B6D048F);
+};
+
+class CInner : public Gem::TGeneric<XInner>
+{
+public:
+    CInner() = default;
+};
+
+class COuter : public Gem::TGeneric<XOuter>
+{
+    Gem::TAggregate<CInner, COuter> m_inner{this};
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_AGGREGATE(XInner, &m_inner)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+class CEmbeddedOuter : public Gem::TGeneric<XOuter>
+{
+    GEM_EMBEDDED_AGGREGATE(CEmbeddedOuter, CInner, m_inner);
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_AGGREGATE(XInner, &m_inner)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+class CLazyOuter : public Gem::TGeneric<XOuter>
+{
+    Gem::TLazyAggregate<CInner, CLazyOuter> m_inner;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_LAZY_AGGREGATE(XInner, m_inner)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+template<class _Outer>
+void RunAggregate(GemBench::Runner &runner, const char *aggregateKind)
+{
+    std::string prefix = std::string("QueryInterface/Aggregate/") + aggregateKind;
+
+    Gem::TGemPtr<_Outer> pOuter;
+    Gem::TGenericImpl<_Outer>::Create(&pOuter);
+    Gem::TGemPtr<XInner> pInner;
+    pOuter->QueryInterface(&pInner);
+
+    runner.Run(prefix + "/FromOuter", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::TGemPtr<XInner> pFound;
+            pOuter->QueryInterface(&pFound);
+            GemBench::DoNotOptimize(pFound);
+        }
+    });
+
+    runner.Run(prefix + "/DelegatedFromInner", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::TGemPtr<XOuter> pFound;
+            pInner->QueryInterface(&pFound);
+            GemBench::DoNotOptimize(pFound);
+        }
+    });
+
+    runner.Run(prefix + "/AddRefReleaseFromInner", [&](unsigned, uint64_t iterations)
+    {
+        XInner *pRaw = pInner;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            pRaw->AddRef();
+            GemBench::DoNotOptimize(pRaw);
+            pRaw->Release();
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(QueryInterfaceByMapSize)
+{
+    RunMapSize<CSwitchMap<1>, 1>(runner, "Switch");
+    RunMapSize<CSwitchMap<8>, 8>(runner, "Switch");
+    RunMapSize<CSwitchMap<32>, 32>(runner, "Switch");
+    RunMapSize<CSwitchMap<128>, 128>(runner, "Switch");
+
+    RunMapSize<CTableMap<1>, 1>(runner, "Table");
+    RunMapSize<CTableMap<8>, 8>(runner, "Table");
+    RunMapSize<CTableMap<32>, 32>(runner, "Table");
+    RunMapSize<CTableMap<128>, 128>(runner, "Table");
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(QueryInterfaceCached)
+{
+    Gem::TGemPtr<CSwitchMap<32>> pObj;
+    Gem::TGenericImpl<CSwitchMap<32>>::Create(&pObj);
+    Gem::XGeneric *pGeneric = pObj->TryAs<Gem::XGeneric>();
+
+    runner.Run("QueryInterface/TryAs", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::TGemRef<XBenchChain<17>> pFound = pGeneric->TryAs<XBenchChain<17>>();
+            GemBench::DoNotOptimize(pFound);
+        }
+    });
+
+    runner.Run("QueryInterface/QueryCache", [&](unsigned, uint64_t iterations)
+    {
+        static Gem::TQueryCache<XBenchChain<17>> s_cache;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::TGemRef<XBenchChain<17>> pFound = s_cache.TryAs(pGeneric);
+            GemBench::DoNotOptimize(pFound);
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(QueryInterfaceAggregate)
+{
+    RunAggregate<COuter>(runner, "Pointer");
+    RunAggregate<CEmbeddedOuter>(runner, "Embedded");
+    RunAggregate<CLazyOuter>(runner, "Lazy");
+}
+
+}
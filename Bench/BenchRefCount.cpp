@@ -0,0 +1,201 @@
+//================================================================================================
+// Reference counting benchmarks
+//
+// - TGemPtr copy, move and reset
+// - AddRef/Release for each threading model, on a per-thread object and on one object
+//   shared by all threads
+// - Resolving weak references
+//================================================================================================
+
+#include "BenchHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <mutex>
+#include <string>
+
+namespace GemBench
+{
+struct XCounted : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XCounted, 0x6C1D2E8F40A75B13);
+
+    GEMMETHOD_(int, Value)() = 0;
+};
+
+class CCounted : public Gem::TGeneric<XCounted>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XCounted)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) Value() override { return 1; }
+};
+
+// Lock-based policy, the usual workaround before TGenericImpl took a threading model
+struct MutexThreadModel
+{
+    struct RefCountType
+    {
+        std::mutex Mutex;
+        unsigned long Count = 0;
+    };
+
+    static unsigned long Increment(RefCountType &refCount) noexcept
+    {
+        std::lock_guard<std::mutex> lock(refCount.Mutex);
+        return ++refCount.Count;
+    }
+
+    static unsigned long Decrement(RefCountType &refCount) noexcept
+    {
+        std::lock_guard<std::mutex> lock(refCount.Mutex);
+        return --refCount.Count;
+    }
+};
+
+template<class _ThreadModel>
+Gem::TGemPtr<CCounted> CreateCounted()
+{
+    Gem::TGemPtr<CCounted> pObj;
+    Gem::TGenericImpl<CCounted, _ThreadModel>::Create(&pObj);
+    return pObj;
+}
+
+//------------------------------------------------------------------------------------------------
+// Every thread counts its own object: the cost of the counter itself
+template<class _ThreadModel>
+void RunUnshared(GemBench::Runner &runner, const char *modelName)
+{
+    std::string name = std::string("RefCount/AddRefRelease/") + modelName + "/Unshared";
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run(name, threads, [](unsigned, uint64_t iterations)
+        {
+            // Created on the measuring thread so biased counts are owned by it
+            Gem::TGemPtr<CCounted> pObj = CreateCounted<_ThreadModel>();
+            XCounted *pRaw = pObj;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                pRaw->AddRef();
+                GemBench::DoNotOptimize(pRaw);
+                pRaw->Release();
+            }
+        });
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// All threads count the same object: the cost under contention
+template<class _ThreadModel>
+void RunShared(GemBench::Runner &runner, const char *modelName)
+{
+    std::string name = std::string("RefCount/AddRefRelease/") + modelName + "/Shared";
+    if (!runner.Enabled(name))
+    {
+        return;
+    }
+
+    Gem::TGemPtr<CCounted> pObj = CreateCounted<_ThreadModel>();
+    XCounted *pRaw = pObj;
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run(name, threads, [pRaw](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                pRaw->AddRef();
+                GemBench::DoNotOptimize(pRaw);
+                pRaw->Release();
+            }
+        });
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(GemPtrOperations)
+{
+    Gem::TGemPtr<CCounted> pSource = CreateCounted<Gem::MultiThreadModel>();
+
+    runner.Run("GemPtr/Copy", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::TGemPtr<CCounted> pCopy(pSource);
+            GemBench::DoNotOptimize(pCopy);
+        }
+    });
+
+    runner.Run("GemPtr/Move", [&](unsigned, uint64_t iterations)
+    {
+        Gem::TGemPtr<CCounted> pA(pSource);
+        Gem::TGemPtr<CCounted> pB;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            pB = std::move(pA);
+            pA = std::move(pB);
+            GemBench::DoNotOptimize(pA);
+        }
+    });
+
+    runner.Run("GemPtr/Reset", [&](unsigned, uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            Gem::TGemPtr<CCounted> pCopy(pSource);
+            GemBench::DoNotOptimize(pCopy);
+            pCopy = nullptr;
+        }
+    });
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(AddRefRelease)
+{
+    RunUnshared<Gem::SingleThreadModel>(runner, "Single");
+    RunUnshared<Gem::MultiThreadModel>(runner, "Multi");
+    RunUnshared<Gem::BiasedThreadModel>(runner, "Biased");
+    RunUnshared<Gem::WeakReferenceThreadModel>(runner, "Weak");
+    RunUnshared<MutexThreadModel>(runner, "Mutex");
+
+    RunShared<Gem::MultiThreadModel>(runner, "Multi");
+    RunShared<Gem::BiasedThreadModel>(runner, "Biased");
+    RunShared<Gem::WeakReferenceThreadModel>(runner, "Weak");
+    RunShared<MutexThreadModel>(runner, "Mutex");
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_BENCHMARK_GROUP(WeakReferences)
+{
+    Gem::TGemPtr<CCounted> pObj = CreateCounted<Gem::WeakReferenceThreadModel>();
+    Gem::TGemWeakPtr<CCounted> pWeak(pObj);
+
+    // Counts now live in the side block
+    runner.Run("RefCount/AddRefRelease/Weak/WithSideBlock", [&](unsigned, uint64_t iterations)
+    {
+        XCounted *pRaw = pObj;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            pRaw->AddRef();
+            GemBench::DoNotOptimize(pRaw);
+            pRaw->Release();
+        }
+    });
+
+    for (unsigned threads : runner.ThreadCounts())
+    {
+        runner.Run("WeakPtr/Resolve", threads, [&](unsigned, uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                Gem::TGemPtr<CCounted> pStrong = pWeak.Resolve();
+                GemBench::DoNotOptimize(pStrong);
+            }
+        });
+    }
+}
+
+}
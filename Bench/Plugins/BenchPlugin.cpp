@@ -0,0 +1,70 @@
+//================================================================================================
+// Synthetic plugin module for the plugin benchmarks
+//
+// Built once per index; GEM_BENCH_PLUGIN_INDEX selects the class id the module provides.
+// Module i > 0 requires the class of module (i - 1) / 2 and creates it while it initializes, and
+// every module runs a fixed amount of CPU work when it is loaded, standing in for real module
+// initialization.
+//================================================================================================
+
+#include "BenchPlugin.hpp"
+#include "../BenchHarness.hpp"
+
+#include <GemPlugin.hpp>
+
+#include <cstdint>
+
+namespace GemBench
+{
+class CPluginService : public Gem::TGeneric<XPluginService>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XPluginService)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) ModuleIndex() override { return GEM_BENCH_PLUGIN_INDEX; }
+};
+
+Gem::Result InitializePlugin([[maybe_unused]] const Gem::PluginHost &host)
+{
+#if GEM_BENCH_PLUGIN_INDEX > 0
+    constexpr int requiredIndex = (GEM_BENCH_PLUGIN_INDEX - 1) / 2;
+    XPluginService *pRequired = nullptr;
+    Gem::Result result = host.CreateInstance(BenchPluginClassId(requiredIndex), GEM_IID_PPV_ARGS(&pRequired));
+    if (Gem::Failed(result))
+    {
+        return result;
+    }
+
+    bool isRequiredModule = pRequired->ModuleIndex() == requiredIndex;
+    pRequired->Release();
+    if (!isRequiredModule)
+    {
+        return Gem::Result::Fail;
+    }
+#endif
+
+    uint64_t value = GEM_BENCH_PLUGIN_INDEX;
+    for (unsigned i = 0; i < BenchPluginInitializeRounds; ++i)
+    {
+        value = (value ^ (value >> 31)) * 0x9e3779b97f4a7c15ULL + i;
+    }
+
+    DoNotOptimize(value);
+    return Gem::Result::Success;
+}
+
+}
+
+GEM_PLUGIN_INITIALIZE(GemBench::InitializePlugin)
+
+#if GEM_BENCH_PLUGIN_INDEX > 0
+GEM_PLUGIN_REQUIRED_CLASSES(GemBench::BenchPluginClassId((GEM_BENCH_PLUGIN_INDEX - 1) / 2))
+#endif
+
+BEGIN_GEM_PLUGIN_CLASS_MAP()
+    GEM_PLUGIN_CLASS_ENTRY(GemBench::BenchPluginClassId(GEM_BENCH_PLUGIN_INDEX), GemBench::CPluginService, GemBench::XPluginService)
+END_GEM_PLUGIN_CLASS_MAP()
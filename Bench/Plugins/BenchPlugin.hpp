@@ -0,0 +1,31 @@
+//================================================================================================
+// Interface and class ids shared by the synthetic benchmark plugins and the host
+//
+// BenchPlugin.cpp is built once per plugin index; module i provides BenchPluginClassId(i) and
+// requires BenchPluginClassId((i - 1) / 2).
+//================================================================================================
+
+#pragma once
+
+#include <Gem.hpp>
+
+#include <cstdint>
+
+namespace GemBench
+{
+struct XPluginService : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XPluginService, 0x3B7D52E91AC06F48);
+
+    GEMMETHOD_(int, ModuleIndex)() = 0;
+};
+
+constexpr uint64_t BenchPluginClassId(unsigned index)
+{
+    return Gem::HashInterfaceName("GemBench::CPluginService") + index;
+}
+
+// Iterations of the work each module does in GemPluginInitialize
+constexpr unsigned BenchPluginInitializeRounds = 1u << 20;
+
+}
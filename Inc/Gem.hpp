@@ -18,7 +18,53 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Per-class live object tracking, see GemTracking.hpp
+#ifdef GEM_ENABLE_OBJECT_TRACKING
+    #include "GemTracking.hpp"
+#endif
+
+// AddRef / Release / QueryInterface tracing, see GemRefTrace.hpp
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+    #include "GemRefTrace.hpp"
+    #define GEM_REFTRACE_NOINLINE GEM_NOINLINE
+    #define GEM_REFTRACE_CALLER() GEM_RETURN_ADDRESS()
+#else
+    #define GEM_REFTRACE_NOINLINE
+    #define GEM_REFTRACE_CALLER() nullptr
+#endif
+
+// Create / Initialize / Uninitialize / Destroy timeline events, see GemLifecycleTrace.hpp
+#ifdef GEM_ENABLE_LIFECYCLE_TRACE
+    #include "GemLifecycleTrace.hpp"
+    #define GEM_LIFECYCLE_SCOPE(name, className, pObject) Gem::LifecycleScope gemLifecycleScope(name, className, pObject)
+#else
+    #define GEM_LIFECYCLE_SCOPE(name, className, pObject)
+#endif
+
+// Builds without exception support (-fno-exceptions, /EHs-) construct objects through the
+// Result-returning path only; defining GEM_EXCEPTIONS overrides the detection
+#ifndef GEM_EXCEPTIONS
+    #if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+        #define GEM_EXCEPTIONS 1
+    #else
+        #define GEM_EXCEPTIONS 0
+    #endif
+#endif
 
 #ifdef _WIN32
     #define GEMNOTHROW __declspec(nothrow)
@@ -26,6 +72,13 @@
     #define GEMNOTHROW
 #endif
 
+// SAL annotations are only available with MSVC
+#ifndef _WIN32
+    #define _In_
+    #define _Outptr_result_nullonfailure_
+    #define _Return_type_success_(expr)
+#endif
+
 // Method declaration macros for COM-style interfaces
 #define GEMMETHOD(method) virtual GEMNOTHROW Gem::Result method
 #define GEMMETHOD_(retType, method) virtual GEMNOTHROW retType method
@@ -40,13 +93,31 @@
     static inline const char *XFaceName = #xface; \
     static constexpr Gem::InterfaceId IId{iid}
 
+// Interface ID declaration macro deriving the IId from a hash of the interface name.
+// Pass the fully qualified name (e.g. MyLib::XWidget) so IIds stay unique across namespaces.
+#define GEM_INTERFACE_DECLARE_HASHED(xface) \
+    using XFace = xface; \
+    static inline const char *XFaceName = #xface; \
+    static constexpr Gem::InterfaceId IId{Gem::HashInterfaceName(#xface)}
+
 // Helper macro for QueryInterface calls with type safety
 #define GEM_IID_PPV_ARGS(ppObj) \
     std::remove_reference_t<decltype(**ppObj)>::IId, reinterpret_cast<void **>(ppObj)
 
 // Use BEGIN_GEM_INTERFACE_MAP() for classes that implement XGeneric
+// The map generates InternalQueryInterfaceBorrowed, which finds the interface without taking a
+// reference, and InternalQueryInterface, which adds the reference on success. Both share the
+// entries in InternalQueryInterfaceMap. Borrowed queries only succeed for interfaces stored
+// inside this object; entries that hand out a separate object (tear-offs, lazy aggregates and
+// aggregates held by pointer) check `borrowed` and fail it with NoInterface.
 #define BEGIN_GEM_INTERFACE_MAP() \
+    GEMMETHOD(InternalQueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) { \
+        return InternalQueryInterfaceMap(iid, ppObj, true); \
+    } \
     GEMMETHOD(InternalQueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) { \
+        return InternalQueryInterfaceMap(iid, ppObj, false); \
+    } \
+    Gem::Result InternalQueryInterfaceMap(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj, bool borrowed) { \
     if (!ppObj) { \
         return Gem::Result::BadPointer; \
     } \
@@ -68,21 +139,124 @@
 // The aggregated object must delegate AddRef/Release to this outer object.
 // This can be accomplished using TAggregateImpl in inheretance chain.
 // This macro returns the aggregated interface pointer and the outer object's
+// Borrowed queries succeed only if pObj is a member of this object (TAggregate or
+// GEM_EMBEDDED_AGGREGATE); an inner object allocated separately is not lent out.
 #define GEM_INTERFACE_ENTRY_AGGREGATE(IFace, pObj) \
     case IFace::IId: \
-        if (pObj) { \
-            *ppObj = pObj; \
-        } else { \
+        if (!(pObj)) { \
             return Gem::Result::BadPointer; \
         } \
+        if (borrowed && !Gem::IsWithinObject(this, pObj)) { \
+            return Gem::Result::NoInterface; \
+        } \
+        *ppObj = pObj; \
+        break;
+
+// Declares member as an embedded aggregate of innerBase inside outerClass (see TEmbeddedAggregate).
+// Use the _TM form when outerClass is instantiated with a non-default threading model.
+#define GEM_EMBEDDED_AGGREGATE(outerClass, innerBase, member) \
+    GEM_EMBEDDED_AGGREGATE_TM(outerClass, Gem::DefaultThreadModel, innerBase, member)
+
+#define GEM_EMBEDDED_AGGREGATE_TM(outerClass, threadModel, innerBase, member) \
+    struct member##Locator \
+    { \
+        GEM_BEGIN_ALLOW_OFFSETOF \
+        static outerClass *Outer(void *pInner) noexcept \
+        { \
+            return reinterpret_cast<outerClass *>(static_cast<char *>(pInner) - offsetof(outerClass, member)); \
+        } \
+        GEM_END_ALLOW_OFFSETOF \
+    }; \
+    Gem::TEmbeddedAggregate<innerBase, outerClass, member##Locator, threadModel> member
+
+// offsetof is conditionally supported on classes with virtual functions; all supported
+// compilers implement it for classes without virtual bases
+#if defined(__GNUC__) || defined(__clang__)
+    #define GEM_BEGIN_ALLOW_OFFSETOF \
+        _Pragma("GCC diagnostic push") \
+        _Pragma("GCC diagnostic ignored \"-Winvalid-offsetof\"")
+    #define GEM_END_ALLOW_OFFSETOF \
+        _Pragma("GCC diagnostic pop")
+#else
+    #define GEM_BEGIN_ALLOW_OFFSETOF
+    #define GEM_END_ALLOW_OFFSETOF
+#endif
+
+// Add a lazily created aggregated interface entry to the interface map
+// slot is a Gem::TLazyAggregate<InnerBase, ThisClass> member; the inner TAggregate is created
+// the first time IFace is queried and lives until this object is destroyed. The inner object is
+// allocated separately, so borrowed queries for IFace fail with NoInterface.
+#define GEM_INTERFACE_ENTRY_LAZY_AGGREGATE(IFace, slot) \
+    case IFace::IId: \
+        if (borrowed) { \
+            return Gem::Result::NoInterface; \
+        } \
+        { \
+            Gem::Result lazyResult = slot.Acquire(this, reinterpret_cast<IFace **>(ppObj)); \
+            if (Gem::Failed(lazyResult)) { \
+                return lazyResult; \
+            } \
+        } \
         break;
 
+// Add a tear-off interface entry to the interface map
+// Each QueryInterface for IFace allocates a new tearOffClass (derived from Gem::TTearOff), which
+// holds a reference on this object and is freed when its own count drops to zero. Borrowed
+// queries for IFace fail with NoInterface, since there is no object to lend.
+#define GEM_INTERFACE_ENTRY_TEAROFF(IFace, tearOffClass) \
+    case IFace::IId: \
+        static_assert(std::is_base_of_v<IFace, tearOffClass>, "Tear-off class does not implement " #IFace); \
+        if (borrowed) { \
+            return Gem::Result::NoInterface; \
+        } \
+        return Gem::QueryTearOff<tearOffClass>(this, nullptr, reinterpret_cast<IFace **>(ppObj));
+
+// Like GEM_INTERFACE_ENTRY_TEAROFF, but queries return the live tear-off recorded in slot (a
+// Gem::TearOffSlot member) while one exists, so at most one instance is alive at a time
+#define GEM_INTERFACE_ENTRY_CACHED_TEAROFF(IFace, tearOffClass, slot) \
+    case IFace::IId: \
+        static_assert(std::is_base_of_v<IFace, tearOffClass>, "Tear-off class does not implement " #IFace); \
+        if (borrowed) { \
+            return Gem::Result::NoInterface; \
+        } \
+        return Gem::QueryTearOff<tearOffClass>(this, &slot, reinterpret_cast<IFace **>(ppObj));
+
 // Complete the interface map
 #define END_GEM_INTERFACE_MAP() \
     } \
-    AddRef(); \
+    if (!borrowed) { \
+        AddRef(); \
+    } \
     return Gem::Result::Success; } \
 
+// Table-driven alternative to BEGIN/END_GEM_INTERFACE_MAP for classes with many interfaces.
+// Entries are interface types or Gem::TAggregateEntry<IFace, &Class::member>; the first entry
+// must be an interface the class derives from and provides the XGeneric identity.
+// QueryInterface binary-searches a table sorted by IId at compile time.
+// The XGeneric methods are redeclared so they are unambiguous when the class derives from
+// several interfaces; TGenericImpl provides the implementations.
+#define GEM_INTERFACE_TABLE(...) \
+    GEMMETHOD_(unsigned long, AddRef)() = 0; \
+    GEMMETHOD_(unsigned long, Release)() = 0; \
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) = 0; \
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) = 0; \
+    template<class _XFace> \
+    Gem::Result QueryInterface(_XFace **ppObj) { \
+        return QueryInterface(_XFace::IId, reinterpret_cast<void **>(ppObj)); \
+    } \
+    template<class _XFace> \
+    Gem::TGemRef<_XFace> TryAs() { \
+        void *pObj = nullptr; \
+        QueryInterfaceBorrowed(_XFace::IId, &pObj); \
+        return Gem::TGemRef<_XFace>(static_cast<_XFace *>(pObj)); \
+    } \
+    GEMMETHOD(InternalQueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) { \
+        return Gem::TInterfaceTable<std::remove_pointer_t<decltype(this)>, __VA_ARGS__>::QueryInterface(this, iid, ppObj); \
+    } \
+    GEMMETHOD(InternalQueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) { \
+        return Gem::TInterfaceTable<std::remove_pointer_t<decltype(this)>, __VA_ARGS__>::QueryInterfaceBorrowed(this, iid, ppObj); \
+    }
+
 namespace Gem
 {
 //------------------------------------------------------------------------------------------------
@@ -99,6 +273,20 @@ struct InterfaceId
 	constexpr operator uint64_t() const { return Value; }
 };
 
+//------------------------------------------------------------------------------------------------
+// 64-bit FNV-1a hash of an interface name, used by GEM_INTERFACE_DECLARE_HASHED
+constexpr uint64_t HashInterfaceName(const char *name)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (; *name; ++name)
+    {
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
 //------------------------------------------------------------------------------------------------
 _Return_type_success_(return >= 0)
 enum class Result : int32_t
@@ -146,6 +334,12 @@ inline const char * GemResultString(Result res)
         return "Unavailable";
     case Gem::Result::Uninitialized:
         return "Uninitialized";
+    case Gem::Result::PluginLoadFailed:
+        return "PluginLoadFailed";
+    case Gem::Result::PluginProcNotFound:
+        return "PluginProcNotFound";
+    case Gem::Result::CorruptedData:
+        return "CorruptedData";
     }
     return "(Unknown)";
 }
@@ -157,6 +351,10 @@ inline bool Succeeded(Result result)
     return result >= Gem::Result::Success;
 }
 
+//------------------------------------------------------------------------------------------------
+template<class _Type>
+class TGemRef;
+
 //------------------------------------------------------------------------------------------------
 template<class _Type>
 class TGemPtr
@@ -271,6 +469,37 @@ public:
     operator _Type *() const { return m_p; }
     
     _Type *operator->() const { return m_p; }
+
+    template<class _XFace>
+    TGemRef<_XFace> TryAs() const
+    {
+        return m_p ? m_p->template TryAs<_XFace>() : TGemRef<_XFace>();
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Non-owning interface pointer, as returned by TryAs. Never calls AddRef or Release; the
+// object must be kept alive by an owning reference for as long as the TGemRef is used.
+template<class _Type>
+class TGemRef
+{
+    _Type *m_p = nullptr;
+
+public:
+    TGemRef() = default;
+    explicit TGemRef(_Type *p) :
+        m_p(p) {}
+
+    _Type &operator*() const
+    {
+        return *m_p;
+    }
+
+    _Type *Get() const { return m_p; }
+
+    operator _Type *() const { return m_p; }
+
+    _Type *operator->() const { return m_p; }
 };
 
 //------------------------------------------------------------------------------------------------
@@ -282,24 +511,55 @@ inline constexpr bool Failed(Gem::Result result) noexcept
 //------------------------------------------------------------------------------------------------
 class GemError
 {
-    const Result m_result;
+    const Gem::Result m_result;
 public:
     GemError() = delete;
-    GemError(Result result) :
+    GemError(Gem::Result result) :
         m_result(result >= Gem::Result::Success ? Gem::Result::Fail : result) {}
 
-    Result Result() const { return m_result; }
+    Gem::Result Result() const { return m_result; }
 };
 
 //------------------------------------------------------------------------------------------------
+// Without exception support a failure here terminates; return the Result from Initialize instead
 inline void ThrowGemError(Result result)
 {
     if (Failed(result))
     {
+#if GEM_EXCEPTIONS
         throw(GemError(result));
+#else
+        std::abort();
+#endif
     }
 }
 
+#if !GEM_EXCEPTIONS
+//------------------------------------------------------------------------------------------------
+template<class _Type, class = void>
+struct THasClassNew : std::false_type {};
+
+template<class _Type>
+struct THasClassNew<_Type, std::void_t<decltype(_Type::operator new(size_t(0)))>> : std::true_type {};
+
+template<class _Type, class = void>
+struct THasClassNothrowNew : std::false_type {};
+
+template<class _Type>
+struct THasClassNothrowNew<_Type, std::void_t<decltype(_Type::operator new(size_t(0), std::nothrow))>> : std::true_type {};
+
+//------------------------------------------------------------------------------------------------
+// Allocates and constructs _Type, returning nullptr when allocation fails. A class-scope
+// operator new hides the global nothrow form, so such classes must declare their own.
+template<class _Type, typename... Arguments>
+_Type *NewNoThrow(Arguments&&... args)
+{
+    static_assert(!THasClassNew<_Type>::value || THasClassNothrowNew<_Type>::value,
+        "Classes with a class-scope operator new need a nothrow operator new without exceptions");
+    return new(std::nothrow) _Type(std::forward<Arguments>(args)...);
+}
+#endif
+
 //------------------------------------------------------------------------------------------------
 // Base interface for all GEM interfaces
 struct XGeneric
@@ -310,154 +570,1728 @@ struct XGeneric
     GEMMETHOD_(unsigned long, Release)() = 0;
     GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) = 0;
 
+    // Like QueryInterface, but does not AddRef the returned interface. The result is only
+    // valid while the caller holds a reference to this object. Only interfaces stored inside
+    // the object can be borrowed; interfaces implemented by separately allocated objects
+    // (tear-offs, lazy aggregates, aggregates held by pointer) fail with NoInterface and must
+    // be queried with QueryInterface.
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) = 0;
+
     template<class _XFace>
     Gem::Result QueryInterface(_XFace **ppObj)
     {
         return QueryInterface(_XFace::IId, reinterpret_cast<void **>(ppObj));
     }
+
+    // Borrowed query for hot paths; returns a null TGemRef if _XFace is not supported
+    template<class _XFace>
+    TGemRef<_XFace> TryAs()
+    {
+        void *pObj = nullptr;
+        QueryInterfaceBorrowed(_XFace::IId, &pObj);
+        return TGemRef<_XFace>(static_cast<_XFace *>(pObj));
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Weak reference to an object, obtained from XWeakReferenceSource. Keeps the reference
+// bookkeeping alive but not the object.
+struct XWeakReference : public XGeneric
+{
+    GEM_INTERFACE_DECLARE(XWeakReference, 0xfffffffffffffffeU);
+
+    // Returns iid on the object with a new reference. If the object has already been
+    // destroyed, succeeds with *ppObj set to null.
+    GEMMETHOD(Resolve)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// Implemented by objects that support weak references (see WeakReferenceThreadModel)
+struct XWeakReferenceSource : public XGeneric
+{
+    GEM_INTERFACE_DECLARE(XWeakReferenceSource, 0xfffffffffffffffdU);
+
+    GEMMETHOD(GetWeakReference)(_Outptr_result_nullonfailure_ XWeakReference **ppWeakRef) = 0;
 };
 
 //------------------------------------------------------------------------------------------------
-template<class _Base>
-class TGenericImpl : public _Base
+// Weak counterpart of TGemPtr. Does not keep the object alive; Resolve returns a strong
+// pointer while the object exists and a null one after it has been destroyed.
+template<class _Type>
+class TGemWeakPtr
 {
-    unsigned long m_RefCount = 0;
+    TGemPtr<XWeakReference> m_pWeakRef;
 
 public:
-    template<typename... Arguments>
-    TGenericImpl(Arguments&&... args) : _Base(args ...)
+    TGemWeakPtr() = default;
+    TGemWeakPtr(_Type *p)
     {
-        this->Initialize();
+        Reset(p);
     }
 
-    virtual ~TGenericImpl()
+    TGemWeakPtr &operator=(_Type *p)
     {
+        Reset(p);
+        return *this;
     }
 
-    // Factory function for proper two-phase initialization
-    template<typename... Args>
-    static Result Create(_Outptr_result_nullonfailure_ _Base **ppObject, Args... args)
+    // Refers to p, or to nothing if p is null. Fails with NoInterface if p does not
+    // implement XWeakReferenceSource.
+    Result Reset(_Type *p = nullptr)
     {
-        if (!ppObject)
-            return Result::BadPointer;
-        
-        *ppObject = nullptr;
-        
-        try
+        m_pWeakRef = nullptr;
+        if (!p)
         {
-            // Phase 1: Construction
-            TGemPtr<_Base> obj = new TGenericImpl<_Base>(args...); // throw std::bad_alloc            
-            *ppObject = obj.Detach();
             return Result::Success;
         }
-        catch (const std::bad_alloc &)
+
+        void *pSource = nullptr;
+        Result result = p->QueryInterfaceBorrowed(XWeakReferenceSource::IId, &pSource);
+        if (Failed(result))
         {
-            return Result::OutOfMemory;
+            return result;
         }
-        catch (const GemError &e)
+
+        return static_cast<XWeakReferenceSource *>(pSource)->GetWeakReference(&m_pWeakRef);
+    }
+
+    TGemPtr<_Type> Resolve() const
+    {
+        TGemPtr<_Type> pObj;
+        if (m_pWeakRef)
         {
-            return e.Result();
+            m_pWeakRef->Resolve(_Type::IId, reinterpret_cast<void **>(&pObj));
         }
+
+        return pObj;
     }
 
-    GEMMETHOD_(unsigned long,AddRef)() final
+    XWeakReference *Get() const { return m_pWeakRef; }
+};
+
+//------------------------------------------------------------------------------------------------
+// True if p points into the storage of *pObject, and so sits at the same offset in every instance
+template<class _Type>
+bool IsWithinObject(const _Type *pObject, const void *p) noexcept
+{
+    const char *pBegin = reinterpret_cast<const char *>(pObject);
+    const char *pByte = static_cast<const char *>(p);
+    return std::less_equal<const char *>()(pBegin, pByte) && std::less<const char *>()(pByte, pBegin + sizeof(_Type));
+}
+
+//------------------------------------------------------------------------------------------------
+// Interface table entry for an aggregated object held in member _pMember (see GEM_INTERFACE_TABLE).
+// The member is part of the object, so the entry can be borrowed.
+template<class _XFace, auto _pMember>
+struct TAggregateEntry {};
+
+//------------------------------------------------------------------------------------------------
+template<class _Class, class _Entry>
+struct TInterfaceTableEntry
+{
+    static constexpr uint64_t IId = _Entry::IId;
+
+    static void *Get(_Class *pObj) noexcept
     {
-        return InternalAddRef();
+        return static_cast<_Entry *>(pObj);
     }
+};
 
-    GEMMETHOD_(unsigned long, Release)() final
+template<class _Class, class _XFace, auto _pMember>
+struct TInterfaceTableEntry<_Class, TAggregateEntry<_XFace, _pMember>>
+{
+    static constexpr uint64_t IId = _XFace::IId;
+
+    static void *Get(_Class *pObj) noexcept
     {
-        return InternalRelease();
+        return static_cast<_XFace *>(&(pObj->*_pMember));
     }
+};
+
+//------------------------------------------------------------------------------------------------
+template<class _Class>
+struct TInterfaceTableRow
+{
+    uint64_t IId;
+    void *(*pfnGet)(_Class *) noexcept;
+};
 
-    unsigned long GEMNOTHROW InternalAddRef()
+//------------------------------------------------------------------------------------------------
+template<class _Class, size_t _Count>
+constexpr std::array<TInterfaceTableRow<_Class>, _Count> SortInterfaceTable(std::array<TInterfaceTableRow<_Class>, _Count> rows)
+{
+    for (size_t i = 1; i < _Count; ++i)
     {
-#ifdef _WIN32
-        return InterlockedIncrement(&m_RefCount);
-#else
-        return ++m_RefCount;  // Note: This is not thread-safe on non-Windows. Consider using std::atomic for true portability.
-#endif
+        for (size_t j = i; j > 0 && rows[j].IId < rows[j - 1].IId; --j)
+        {
+            TInterfaceTableRow<_Class> row = rows[j];
+            rows[j] = rows[j - 1];
+            rows[j - 1] = row;
+        }
     }
 
-    unsigned long GEMNOTHROW InternalRelease()
-    {
-#ifdef _WIN32
-        auto result = InterlockedDecrement(&m_RefCount);
-#else
-        auto result = --m_RefCount;  // Note: This is not thread-safe on non-Windows. Consider using std::atomic for true portability.
-#endif
+    return rows;
+}
 
-        if (0UL == result)
+//------------------------------------------------------------------------------------------------
+template<class _Class, size_t _Count>
+constexpr bool InterfaceTableIsUnique(const std::array<TInterfaceTableRow<_Class>, _Count> &rows)
+{
+    for (size_t i = 1; i < _Count; ++i)
+    {
+        if (rows[i].IId == rows[i - 1].IId)
         {
-            this->Uninitialize();
-            delete(this);
+            return false;
         }
+    }
 
-        return result;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------
+// Compile-time sorted {IId, accessor} table searched by GEM_INTERFACE_TABLE. Lookup cost is
+// logarithmic in the number of entries and does not depend on the order they are listed in.
+template<class _Class, class _First, class... _Entries>
+class TInterfaceTable
+{
+    static constexpr size_t Count = sizeof...(_Entries) + 2;
+
+    static void *GetGeneric(_Class *pObj) noexcept
+    {
+        return Identity(pObj);
     }
 
-    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    static XGeneric *Identity(_Class *pObj) noexcept
+    {
+        return static_cast<XGeneric *>(static_cast<_First *>(pObj));
+    }
+
+    static constexpr std::array<TInterfaceTableRow<_Class>, Count> Rows = SortInterfaceTable<_Class, Count>({{
+        { XGeneric::IId, &GetGeneric },
+        { TInterfaceTableEntry<_Class, _First>::IId, &TInterfaceTableEntry<_Class, _First>::Get },
+        { TInterfaceTableEntry<_Class, _Entries>::IId, &TInterfaceTableEntry<_Class, _Entries>::Get }...
+    }});
+
+    static_assert(InterfaceTableIsUnique<_Class, Count>(Rows), "Interface table contains duplicate IIds");
+
+public:
+    static Gem::Result QueryInterfaceBorrowed(_Class *pObj, Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) noexcept
     {
         if (!ppObj)
         {
             return Gem::Result::BadPointer;
         }
 
-        return _Base::InternalQueryInterface(iid, ppObj);
+        *ppObj = nullptr;
+
+        size_t first = 0;
+        size_t count = Count;
+        while (count > 0)
+        {
+            size_t half = count / 2;
+            if (Rows[first + half].IId < iid.Value)
+            {
+                first += half + 1;
+                count -= half + 1;
+            }
+            else
+            {
+                count = half;
+            }
+        }
+
+        if (first == Count || Rows[first].IId != iid.Value)
+        {
+            return Gem::Result::NoInterface;
+        }
+
+        *ppObj = Rows[first].pfnGet(pObj);
+        return Gem::Result::Success;
+    }
+
+    static Gem::Result QueryInterface(_Class *pObj, Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) noexcept
+    {
+        Gem::Result result = QueryInterfaceBorrowed(pObj, iid, ppObj);
+        if (Gem::Succeeded(result))
+        {
+            Identity(pObj)->AddRef();
+        }
+
+        return result;
     }
 };
 
 //------------------------------------------------------------------------------------------------
-template<class _Base, class _OuterClass>
-struct TAggregate : public _Base
+// Threading models select the reference count type of TGenericImpl and the operations on it.
+// A user-supplied model must provide the same members:
+//   RefCountType - counter storage, value-initialized to zero
+//   Increment    - adds a reference and returns the new count
+//   Decrement    - removes a reference and returns the new count; zero destroys the object
+//   Bind         - (optional) see ThreadModelHasBind
+struct SingleThreadModel
 {
-    _OuterClass *m_pOuter;
+    using RefCountType = unsigned long;
 
-    template<typename... Arguments>
-    TAggregate(_In_ _OuterClass *pOuter, Arguments... params) :
-        _Base(params...),
-        m_pOuter(pOuter)
+    static unsigned long Increment(RefCountType &refCount) noexcept
     {
+        return ++refCount;
     }
 
-    // Always delegate AddRef to outer generic for proper aggregation
-    GEMMETHOD_(unsigned long,AddRef)() final
+    static unsigned long Decrement(RefCountType &refCount) noexcept
     {
-        return m_pOuter->AddRef();
+        return --refCount;
     }
+};
 
-    // Always delegate Release to outer generic for proper aggregation
-    GEMMETHOD_(unsigned long, Release)() final
+//------------------------------------------------------------------------------------------------
+struct MultiThreadModel
+{
+    using RefCountType = std::atomic<unsigned long>;
+
+    static unsigned long Increment(RefCountType &refCount) noexcept
     {
-        return m_pOuter->Release();
+        // The caller already holds a reference, so a new one needs no ordering
+        return refCount.fetch_add(1, std::memory_order_relaxed) + 1;
     }
-    // Delegate ALL QueryInterface calls to outer object for proper COM aggregation identity
-    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
-    {
-        if (!ppObj)
-        {
-            return Gem::Result::BadPointer;
-        }
 
-        // Always delegate to outer object - it knows about both outer and inner interfaces
-        return m_pOuter->QueryInterface(iid, ppObj);
+    static unsigned long Decrement(RefCountType &refCount) noexcept
+    {
+        // Release publishes this thread's writes to the object; acquire makes all
+        // of them visible to the thread that runs Uninitialize and the destructor.
+        return refCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
     }
 };
 
 //------------------------------------------------------------------------------------------------
-// Custom interfaces must derive from TGeneric<_Xface>
-template<class _Xface>
-class TGeneric : public _Xface
+// Biased reference counting for objects that are mostly used by the thread that created them.
+// The owner thread counts its references in a plain integer; every other thread uses an atomic
+// shared count. When the owner's local count drops to zero it is merged into the shared count
+// and from then on all threads use the shared count.
+//
+// A reference taken on the owner thread and released elsewhere (e.g. a TGemPtr moved to a worker)
+// drives the shared count negative. The object is then queued to its owner, which merges the two
+// counts the next time it calls ProcessQueuedReleases() or when it exits. Long-lived owner threads
+// should call ProcessQueuedReleases() periodically (e.g. once per frame).
+class BiasedThreadModel
 {
 public:
-    virtual ~TGeneric() = default;
-    GEMMETHOD(InternalQueryInterface)(Gem::InterfaceId /*iid*/, _Outptr_result_nullonfailure_ void **ppUnk)
+    class RefCountType;
+
+private:
+    // Per-thread merge queue. Owners are recycled when their thread exits, so objects created by
+    // an exited thread are adopted by the next thread to attach.
+    struct Owner
     {
-        *ppUnk = nullptr;
-        return Gem::Result::NoInterface;
+        std::mutex Mutex;
+        bool Attached = false;
+        RefCountType *pQueued = nullptr;
+    };
+
+    static constexpr int64_t QueuedFlag = 1;
+    static constexpr int64_t MergedFlag = 2;
+    static constexpr int FlagBits = 2;
+    static constexpr int64_t SharedOne = int64_t(1) << FlagBits;
+
+    static inline thread_local Owner *t_pOwner = nullptr;
+
+    static Owner *MergedOwner() noexcept
+    {
+        static Owner merged;
+        return &merged;
     }
 
-    virtual void Uninitialize() {}
+    static int64_t SharedCount(int64_t shared) noexcept
+    {
+        return shared >> FlagBits;
+    }
+
+    // Release results other than zero are informational only
+    static unsigned long NonZeroCount(int64_t count) noexcept
+    {
+        return count > 0 ? static_cast<unsigned long>(count) : 1UL;
+    }
+
+    class OwnerAttachment
+    {
+        Owner *m_pOwner;
+
+    public:
+        OwnerAttachment()
+        {
+            std::lock_guard<std::mutex> poolLock(PoolMutex());
+            auto &pool = OwnerPool();
+            if (pool.empty())
+            {
+                m_pOwner = new Owner;
+            }
+            else
+            {
+                m_pOwner = pool.back();
+                pool.pop_back();
+            }
+
+            std::lock_guard<std::mutex> lock(m_pOwner->Mutex);
+            m_pOwner->Attached = true;
+            t_pOwner = m_pOwner;
+        }
+
+        ~OwnerAttachment()
+        {
+            for (;;)
+            {
+                RefCountType *pQueued;
+                {
+                    std::lock_guard<std::mutex> lock(m_pOwner->Mutex);
+                    pQueued = m_pOwner->pQueued;
+                    m_pOwner->pQueued = nullptr;
+                    if (!pQueued)
+                    {
+                        // Later merges are done by the releasing thread under the owner lock
+                        m_pOwner->Attached = false;
+                        break;
+                    }
+                }
+                ProcessList(pQueued);
+            }
+
+            t_pOwner = nullptr;
+            std::lock_guard<std::mutex> poolLock(PoolMutex());
+            OwnerPool().push_back(m_pOwner);
+        }
+    };
+
+    static std::mutex &PoolMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // Owners are never freed; objects may outlive the thread that created them
+    static std::vector<Owner *> &OwnerPool()
+    {
+        static std::vector<Owner *> *pPool = new std::vector<Owner *>;
+        return *pPool;
+    }
+
+    static Owner *AttachCurrentThread()
+    {
+        static thread_local OwnerAttachment attachment;
+        return t_pOwner;
+    }
+
+    // Moves the owner's local count into the shared count. Returns true if no references remain.
+    // Must be called on the owner thread, or under the owner lock once the owner has detached.
+    static bool Merge(RefCountType &refCount) noexcept
+    {
+        int64_t local = static_cast<int64_t>(refCount.m_LocalCount);
+        refCount.m_LocalCount = 0;
+        refCount.m_pOwner.store(MergedOwner(), std::memory_order_relaxed);
+
+        int64_t shared = refCount.m_Shared.load(std::memory_order_relaxed);
+        int64_t merged;
+        do
+        {
+            merged = ((shared + local * SharedOne) | MergedFlag) & ~QueuedFlag;
+        } while (!refCount.m_Shared.compare_exchange_weak(shared, merged, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        return SharedCount(merged) == 0;
+    }
+
+    static void ProcessList(RefCountType *pQueued) noexcept
+    {
+        while (pQueued)
+        {
+            // The object may be destroyed by the merge
+            RefCountType *pNext = pQueued->m_pNextQueued;
+            if (Merge(*pQueued))
+            {
+                pQueued->m_pfnFinalRelease(pQueued->m_pObject);
+            }
+            pQueued = pNext;
+        }
+    }
+
+    static void Enqueue(Owner *pOwner, RefCountType &refCount) noexcept
+    {
+        bool finalRelease;
+        {
+            std::lock_guard<std::mutex> lock(pOwner->Mutex);
+            if (pOwner->Attached)
+            {
+                refCount.m_pNextQueued = pOwner->pQueued;
+                pOwner->pQueued = &refCount;
+                return;
+            }
+
+            // Nobody owns the local count anymore, so merge it here
+            finalRelease = Merge(refCount);
+        }
+
+        if (finalRelease)
+        {
+            refCount.m_pfnFinalRelease(refCount.m_pObject);
+        }
+    }
+
+public:
+    class RefCountType
+    {
+        friend class BiasedThreadModel;
+
+        std::atomic<Owner *> m_pOwner{AttachCurrentThread()};
+        unsigned long m_LocalCount = 0;
+        std::atomic<int64_t> m_Shared{0};
+        RefCountType *m_pNextQueued = nullptr;
+        void *m_pObject = nullptr;
+        void (*m_pfnFinalRelease)(void *) = nullptr;
+    };
+
+    static void Bind(RefCountType &refCount, void *pObject, void (*pfnFinalRelease)(void *)) noexcept
+    {
+        refCount.m_pObject = pObject;
+        refCount.m_pfnFinalRelease = pfnFinalRelease;
+    }
+
+    static unsigned long Increment(RefCountType &refCount) noexcept
+    {
+        if (refCount.m_pOwner.load(std::memory_order_relaxed) == t_pOwner)
+        {
+            return ++refCount.m_LocalCount;
+        }
+
+        return NonZeroCount(SharedCount(refCount.m_Shared.fetch_add(SharedOne, std::memory_order_relaxed)) + 1);
+    }
+
+    static unsigned long Decrement(RefCountType &refCount) noexcept
+    {
+        Owner *pOwner = refCount.m_pOwner.load(std::memory_order_relaxed);
+        if (pOwner == t_pOwner)
+        {
+            if (--refCount.m_LocalCount != 0)
+            {
+                return refCount.m_LocalCount;
+            }
+
+            // Last owner reference: hand the object over to the shared count
+            refCount.m_pOwner.store(MergedOwner(), std::memory_order_relaxed);
+            int64_t shared = refCount.m_Shared.fetch_or(MergedFlag, std::memory_order_acq_rel);
+            if (shared & QueuedFlag)
+            {
+                // Already in this thread's queue, which completes the release
+                return 1;
+            }
+
+            return SharedCount(shared) == 0 ? 0 : NonZeroCount(SharedCount(shared));
+        }
+
+        int64_t shared = refCount.m_Shared.load(std::memory_order_relaxed);
+        int64_t next;
+        do
+        {
+            next = shared - SharedOne;
+            if (SharedCount(next) < 0 && !(next & MergedFlag))
+            {
+                next |= QueuedFlag;
+            }
+        } while (!refCount.m_Shared.compare_exchange_weak(shared, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        if ((next & QueuedFlag) && !(shared & QueuedFlag))
+        {
+            Enqueue(pOwner, refCount);
+            return 1;
+        }
+
+        if ((next & (MergedFlag | QueuedFlag)) == MergedFlag && SharedCount(next) == 0)
+        {
+            return 0;
+        }
+
+        return NonZeroCount(SharedCount(next));
+    }
+
+    // Merges objects whose owner references were released on other threads
+    static void ProcessQueuedReleases() noexcept
+    {
+        Owner *pOwner = t_pOwner;
+        if (!pOwner)
+        {
+            return;
+        }
+
+        RefCountType *pQueued;
+        {
+            std::lock_guard<std::mutex> lock(pOwner->Mutex);
+            pQueued = pOwner->pQueued;
+            pOwner->pQueued = nullptr;
+        }
+
+        ProcessList(pQueued);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+using DefaultThreadModel = MultiThreadModel;
+
+//------------------------------------------------------------------------------------------------
+// Threading models that release objects outside of Release (such as BiasedThreadModel) provide
+// Bind to learn how to finish the release of the object that owns the count
+template<class _ThreadModel, class = void>
+struct ThreadModelHasBind : std::false_type {};
+
+template<class _ThreadModel>
+struct ThreadModelHasBind<_ThreadModel, std::void_t<decltype(&_ThreadModel::Bind)>> : std::true_type {};
+
+//------------------------------------------------------------------------------------------------
+// Side block holding the counts of an object once a weak reference to it exists. The block is
+// the XWeakReference handed out for the object; it is freed when the object and every weak
+// reference are gone.
+class WeakReferenceBlock final : public XWeakReference
+{
+public:
+    // Reports the strong reference Resolve adds to the object (see GEM_ENABLE_REFCOUNT_TRACING)
+    using PfnTraceAddRef = void (*)(void *pTraceObject, unsigned long count, const void *pCaller);
+
+private:
+    std::atomic<unsigned long> m_Strong;
+    std::atomic<unsigned long> m_Weak{1};   // Weak references, plus one held by the object
+    XGeneric *m_pObject;
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+    void *m_pTraceObject;
+    PfnTraceAddRef m_pfnTraceAddRef;
+#endif
+
+    friend class WeakReferenceThreadModel;
+
+    WeakReferenceBlock(XGeneric *pObject, unsigned long strong, [[maybe_unused]] void *pTraceObject,
+        [[maybe_unused]] PfnTraceAddRef pfnTraceAddRef) noexcept :
+        m_Strong(strong),
+        m_pObject(pObject)
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        , m_pTraceObject(pTraceObject),
+        m_pfnTraceAddRef(pfnTraceAddRef)
+#endif
+    {
+    }
+
+    // Adds a strong reference unless the object is already being destroyed. Returns the new
+    // count, or 0 if no reference was added.
+    unsigned long TryAddStrong() noexcept
+    {
+        unsigned long count = m_Strong.load(std::memory_order_relaxed);
+        while (count != 0)
+        {
+            if (m_Strong.compare_exchange_weak(count, count + 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return count + 1;
+            }
+        }
+
+        return 0;
+    }
+
+public:
+    GEMMETHOD_(unsigned long, AddRef)() final
+    {
+        return m_Weak.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    GEMMETHOD_(unsigned long, Release)() final
+    {
+        unsigned long result = m_Weak.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (0UL == result)
+        {
+            delete(this);
+        }
+
+        return result;
+    }
+
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        Gem::Result result = QueryInterfaceBorrowed(iid, ppObj);
+        if (Gem::Succeeded(result))
+        {
+            AddRef();
+        }
+
+        return result;
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if (iid != XGeneric::IId && iid != XWeakReference::IId)
+        {
+            *ppObj = nullptr;
+            return Gem::Result::NoInterface;
+        }
+
+        *ppObj = static_cast<XWeakReference *>(this);
+        return Gem::Result::Success;
+    }
+
+    GEM_REFTRACE_NOINLINE GEMMETHOD(Resolve)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        *ppObj = nullptr;
+        unsigned long strong = TryAddStrong();
+        if (!strong)
+        {
+            return Gem::Result::Success;
+        }
+
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        // Pairs with the traced Release below
+        if (m_pfnTraceAddRef)
+        {
+            m_pfnTraceAddRef(m_pTraceObject, strong, GEM_REFTRACE_CALLER());
+        }
+#endif
+
+        Gem::Result result = m_pObject->QueryInterface(iid, ppObj);
+        m_pObject->Release();
+        return result;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Thread-safe model that also lets TGenericImpl hand out weak references through
+// XWeakReferenceSource. The count lives in a single tagged word until the first weak reference
+// is requested; only then is a WeakReferenceBlock allocated and the count moved into it, so
+// objects that are never weakly referenced pay one word like MultiThreadModel.
+class WeakReferenceThreadModel
+{
+    static constexpr uintptr_t BlockFlag = 1;
+    static constexpr uintptr_t CountOne = 2;
+
+public:
+    // Inline: count * CountOne. After the first weak reference: WeakReferenceBlock pointer | BlockFlag.
+    class RefCountType
+    {
+        std::atomic<uintptr_t> m_Value{0};
+
+        friend class WeakReferenceThreadModel;
+
+    public:
+        RefCountType() = default;
+        RefCountType(const RefCountType &) = delete;
+        RefCountType &operator=(const RefCountType &) = delete;
+
+        // Runs as the object is destroyed: drops the object's hold on the block
+        ~RefCountType()
+        {
+            uintptr_t value = m_Value.load(std::memory_order_acquire);
+            if (value & BlockFlag)
+            {
+                reinterpret_cast<WeakReferenceBlock *>(value & ~BlockFlag)->Release();
+            }
+        }
+    };
+
+    static unsigned long Increment(RefCountType &refCount) noexcept
+    {
+        uintptr_t value = refCount.m_Value.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (value & BlockFlag)
+            {
+                WeakReferenceBlock *pBlock = reinterpret_cast<WeakReferenceBlock *>(value & ~BlockFlag);
+                return pBlock->m_Strong.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+
+            // Compare-exchange rather than fetch_add, since the word may turn into a block pointer
+            if (refCount.m_Value.compare_exchange_weak(value, value + CountOne, std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return static_cast<unsigned long>(value / CountOne + 1);
+            }
+        }
+    }
+
+    static unsigned long Decrement(RefCountType &refCount) noexcept
+    {
+        uintptr_t value = refCount.m_Value.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (value & BlockFlag)
+            {
+                WeakReferenceBlock *pBlock = reinterpret_cast<WeakReferenceBlock *>(value & ~BlockFlag);
+                return pBlock->m_Strong.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            }
+
+            if (refCount.m_Value.compare_exchange_weak(value, value - CountOne, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return static_cast<unsigned long>(value / CountOne - 1);
+            }
+        }
+    }
+
+    // Returns the weak reference for pObject (its XGeneric identity), moving the count into a
+    // new side block on first use. The caller must hold a reference to the object.
+    // pfnTraceAddRef(pTraceObject, ...) is called for each strong reference Resolve adds when
+    // reference count tracing is enabled.
+    static Result GetWeakReference(RefCountType &refCount, XGeneric *pObject, _Outptr_result_nullonfailure_ XWeakReference **ppWeakRef,
+        void *pTraceObject = nullptr, WeakReferenceBlock::PfnTraceAddRef pfnTraceAddRef = nullptr) noexcept
+    {
+        if (!ppWeakRef)
+        {
+            return Result::BadPointer;
+        }
+
+        *ppWeakRef = nullptr;
+
+        WeakReferenceBlock *pNewBlock = nullptr;
+        uintptr_t value = refCount.m_Value.load(std::memory_order_acquire);
+        while (!(value & BlockFlag))
+        {
+            unsigned long strong = static_cast<unsigned long>(value / CountOne);
+            if (!pNewBlock)
+            {
+                pNewBlock = new(std::nothrow) WeakReferenceBlock(pObject, strong, pTraceObject, pfnTraceAddRef);
+                if (!pNewBlock)
+                {
+                    return Result::OutOfMemory;
+                }
+            }
+
+            pNewBlock->m_Strong.store(strong, std::memory_order_relaxed);
+            uintptr_t blockValue = reinterpret_cast<uintptr_t>(pNewBlock) | BlockFlag;
+            if (refCount.m_Value.compare_exchange_weak(value, blockValue, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                value = blockValue;
+                pNewBlock = nullptr;
+            }
+        }
+
+        // Another thread installed its block first
+        delete pNewBlock;
+
+        WeakReferenceBlock *pBlock = reinterpret_cast<WeakReferenceBlock *>(value & ~BlockFlag);
+        pBlock->AddRef();
+        *ppWeakRef = pBlock;
+        return Result::Success;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Threading models that can produce weak references (such as WeakReferenceThreadModel) provide
+// GetWeakReference; TGenericImpl then implements XWeakReferenceSource
+template<class _ThreadModel, class = void>
+struct ThreadModelHasWeakReference : std::false_type {};
+
+template<class _ThreadModel>
+struct ThreadModelHasWeakReference<_ThreadModel, std::void_t<decltype(&_ThreadModel::GetWeakReference)>> : std::true_type {};
+
+//------------------------------------------------------------------------------------------------
+// XWeakReferenceSource implementation mixed into TGenericImpl<..., _ThreadModel> when the model
+// supports weak references; empty otherwise
+template<class _Impl, class _ThreadModel, bool = ThreadModelHasWeakReference<_ThreadModel>::value>
+class TWeakReferenceSourceImpl
+{
+};
+
+template<class _Impl, class _ThreadModel>
+class TWeakReferenceSourceImpl<_Impl, _ThreadModel, true> : public XWeakReferenceSource
+{
+public:
+    GEMMETHOD(GetWeakReference)(_Outptr_result_nullonfailure_ XWeakReference **ppWeakRef) final
+    {
+        return static_cast<_Impl *>(this)->InternalGetWeakReference(ppWeakRef);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Name used for an implementation class in diagnostics: the XFaceName of its interface, or
+// "(unnamed)" when the class implements several interfaces and the name is ambiguous
+template<class _Class, class = void>
+struct TClassName
+{
+    static constexpr const char *Get() noexcept { return "(unnamed)"; }
+};
+
+template<class _Class>
+struct TClassName<_Class, std::void_t<decltype(_Class::XFaceName)>>
+{
+    static const char *Get() noexcept { return _Class::XFaceName; }
+};
+
+//------------------------------------------------------------------------------------------------
+template<class _Base, class _ThreadModel>
+class TResourceGenericImpl;
+
+//------------------------------------------------------------------------------------------------
+template<class _Base, class _ThreadModel = DefaultThreadModel>
+class TGenericImpl : public _Base, public TWeakReferenceSourceImpl<TGenericImpl<_Base, _ThreadModel>, _ThreadModel>
+{
+    typename _ThreadModel::RefCountType m_RefCount{};
+
+#ifdef GEM_ENABLE_OBJECT_TRACKING
+    static TrackedClass &TrackedClassInfo()
+    {
+        static std::atomic<TrackedClass *> s_pClass{nullptr};
+        return TrackedClass::Get(s_pClass, TClassName<_Base>::Get(), sizeof(TGenericImpl));
+    }
+
+    TrackedObject m_Tracking{TrackedClassInfo(), this};
+#endif
+
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+    static RefTraceClass &RefTraceClassInfo()
+    {
+        static RefTraceClass *s_pClass = new RefTraceClass(TClassName<_Base>::Get());
+        return *s_pClass;
+    }
+
+    // Static and given only the object's address, so a Release can be recorded after another
+    // thread may already have destroyed the object
+    static bool ShouldTraceRefCount(const void *pObject) noexcept
+    {
+        return RefCountTracer::Active() && RefCountTracer::ShouldTrace(RefTraceClassInfo(), pObject);
+    }
+
+    static void RecordRefCount(const void *pObject, RefTraceOp op, unsigned long count, InterfaceId iid, Result result, const void *pReturnAddress) noexcept
+    {
+        RefCountTracer::Record(RefTraceClassInfo(), pObject, op, count, iid, static_cast<int32_t>(result), pReturnAddress);
+    }
+
+    static void TraceRefCount(const void *pObject, RefTraceOp op, unsigned long count, InterfaceId iid, Result result, const void *pReturnAddress) noexcept
+    {
+        if (ShouldTraceRefCount(pObject))
+        {
+            RecordRefCount(pObject, op, count, iid, result, pReturnAddress);
+        }
+    }
+
+    static void TraceWeakAddRef(void *pObject, unsigned long count, const void *pCaller) noexcept
+    {
+        TraceRefCount(pObject, RefTraceOp::AddRef, count, InterfaceId(0), Result::Success, pCaller);
+    }
+#endif
+
+    // Also reached from queued releases (BiasedThreadModel), which never see a zero count in Release
+    void FinalRelease()
+    {
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        if (ShouldTraceRefCount(this))
+        {
+            RecordRefCount(this, RefTraceOp::Destroy, 0, InterfaceId(0), Result::Success, nullptr);
+            RefCountTracer::ObjectDestroyed(this);
+        }
+#endif
+
+
+        {
+            GEM_LIFECYCLE_SCOPE("Uninitialize", TClassName<_Base>::Get(), this);
+            this->Uninitialize();
+        }
+
+        GEM_LIFECYCLE_SCOPE("Destroy", TClassName<_Base>::Get(), this);
+        delete(this);
+    }
+
+    static void FinalReleaseThunk(void *pObject)
+    {
+        static_cast<TGenericImpl *>(pObject)->FinalRelease();
+    }
+
+    // A Result-returning Initialize runs here rather than in the constructor, so it can fail
+    // without throwing. A void Initialize has already run in the constructor.
+    Result CallInitialize()
+    {
+        if constexpr (std::is_void_v<decltype(this->Initialize())>)
+        {
+            return Result::Success;
+        }
+        else
+        {
+            GEM_LIFECYCLE_SCOPE("Initialize", TClassName<_Base>::Get(), this);
+            return this->Initialize();
+        }
+    }
+
+    // Phase 2 of Create: initializes the constructed object and hands out the first reference.
+    // An object that fails to initialize is destroyed without Uninitialize.
+    static Result FinishCreate(TGenericImpl *pObject, _Base **ppObject)
+    {
+        std::unique_ptr<TGenericImpl> guard(pObject);
+        Result result = pObject->CallInitialize();
+        if (Failed(result))
+            return result;
+
+        TGemPtr<_Base> obj = guard.release();
+        *ppObject = obj.Detach();
+        return Result::Success;
+    }
+
+public:
+    using ThreadModel = _ThreadModel;
+
+    template<typename... Arguments>
+    TGenericImpl(Arguments&&... args) : _Base(std::forward<Arguments>(args)...)
+    {
+        if constexpr (ThreadModelHasBind<_ThreadModel>::value)
+        {
+            _ThreadModel::Bind(m_RefCount, this, &FinalReleaseThunk);
+        }
+
+        if constexpr (std::is_void_v<decltype(this->Initialize())>)
+        {
+            GEM_LIFECYCLE_SCOPE("Initialize", TClassName<_Base>::Get(), this);
+            this->Initialize();
+        }
+    }
+
+    virtual ~TGenericImpl()
+    {
+    }
+
+    // Factory function for proper two-phase initialization
+    template<typename... Args>
+    static Result Create(_Outptr_result_nullonfailure_ _Base **ppObject, Args&&... args)
+    {
+        if (!ppObject)
+            return Result::BadPointer;
+        
+        *ppObject = nullptr;
+
+        GEM_LIFECYCLE_SCOPE("Create", TClassName<_Base>::Get(), nullptr);
+        
+#if GEM_EXCEPTIONS
+        try
+        {
+            // Phase 1: Construction
+            return FinishCreate(new TGenericImpl(std::forward<Args>(args)...), ppObject); // throw std::bad_alloc
+        }
+        catch (const std::bad_alloc &)
+        {
+            return Result::OutOfMemory;
+        }
+        catch (const GemError &e)
+        {
+            return e.Result();
+        }
+#else
+        // Phase 1: Construction
+        TGenericImpl *pObject = NewNoThrow<TGenericImpl>(std::forward<Args>(args)...);
+        if (!pObject)
+            return Result::OutOfMemory;
+
+        return FinishCreate(pObject, ppObject);
+#endif
+    }
+
+    // Factory function that allocates the object from pResource instead of the global heap.
+    // The resource must outlive the object; the final Release returns the memory to it.
+    template<typename... Args>
+    static Result CreateWith(_In_ std::pmr::memory_resource *pResource, _Outptr_result_nullonfailure_ _Base **ppObject, Args&&... args)
+    {
+        if (!ppObject || !pResource)
+            return Result::BadPointer;
+
+        *ppObject = nullptr;
+
+        GEM_LIFECYCLE_SCOPE("Create", TClassName<_Base>::Get(), nullptr);
+
+#if GEM_EXCEPTIONS
+        try
+        {
+            return FinishCreate(new(pResource) TResourceGenericImpl<_Base, _ThreadModel>(std::forward<Args>(args)...), ppObject); // throw std::bad_alloc
+        }
+        catch (const std::bad_alloc &)
+        {
+            return Result::OutOfMemory;
+        }
+        catch (const GemError &e)
+        {
+            return e.Result();
+        }
+#else
+        // memory_resource::allocate can only report failure by throwing, so without
+        // exceptions an exhausted resource terminates here
+        return FinishCreate(new(pResource) TResourceGenericImpl<_Base, _ThreadModel>(std::forward<Args>(args)...), ppObject);
+#endif
+    }
+
+    GEM_REFTRACE_NOINLINE GEMMETHOD_(unsigned long,AddRef)() final
+    {
+        return InternalAddRef(GEM_REFTRACE_CALLER());
+    }
+
+    GEM_REFTRACE_NOINLINE GEMMETHOD_(unsigned long, Release)() final
+    {
+        return InternalRelease(GEM_REFTRACE_CALLER());
+    }
+
+    // pCaller is only used by reference count tracing
+    unsigned long GEMNOTHROW InternalAddRef([[maybe_unused]] const void *pCaller = nullptr)
+    {
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        auto result = _ThreadModel::Increment(m_RefCount);
+        TraceRefCount(this, RefTraceOp::AddRef, result, InterfaceId(0), Result::Success, pCaller);
+        return result;
+#else
+        return _ThreadModel::Increment(m_RefCount);
+#endif
+    }
+
+    unsigned long GEMNOTHROW InternalRelease([[maybe_unused]] const void *pCaller = nullptr)
+    {
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        // Decided while the object is alive: once the count drops, another thread may destroy it
+        // and a new object may take its address
+        const void *pObject = this;
+        bool isTraced = ShouldTraceRefCount(pObject);
+        auto result = _ThreadModel::Decrement(m_RefCount);
+        if (isTraced)
+        {
+            RecordRefCount(pObject, RefTraceOp::Release, result, InterfaceId(0), Result::Success, pCaller);
+        }
+#else
+        auto result = _ThreadModel::Decrement(m_RefCount);
+#endif
+
+        if (0UL == result)
+        {
+            FinalRelease();
+        }
+
+        return result;
+    }
+
+    Result GEMNOTHROW InternalGetWeakReference(_Outptr_result_nullonfailure_ XWeakReference **ppWeakRef)
+    {
+        void *pIdentity = nullptr;
+        _Base::InternalQueryInterfaceBorrowed(XGeneric::IId, &pIdentity);
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        return _ThreadModel::GetWeakReference(m_RefCount, static_cast<XGeneric *>(pIdentity), ppWeakRef, this, &TraceWeakAddRef);
+#else
+        return _ThreadModel::GetWeakReference(m_RefCount, static_cast<XGeneric *>(pIdentity), ppWeakRef);
+#endif
+    }
+
+    GEM_REFTRACE_NOINLINE GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if constexpr (ThreadModelHasWeakReference<_ThreadModel>::value)
+        {
+            if (iid == XWeakReferenceSource::IId)
+            {
+                *ppObj = static_cast<XWeakReferenceSource *>(this);
+                AddRef();
+                return Gem::Result::Success;
+            }
+        }
+
+#ifdef GEM_ENABLE_REFCOUNT_TRACING
+        Result result = _Base::InternalQueryInterface(iid, ppObj);
+        TraceRefCount(this, RefTraceOp::QueryInterface, 0, iid, result, GEM_REFTRACE_CALLER());
+        return result;
+#else
+        return _Base::InternalQueryInterface(iid, ppObj);
+#endif
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if constexpr (ThreadModelHasWeakReference<_ThreadModel>::value)
+        {
+            if (iid == XWeakReferenceSource::IId)
+            {
+                *ppObj = static_cast<XWeakReferenceSource *>(this);
+                return Gem::Result::Success;
+            }
+        }
+
+        return _Base::InternalQueryInterfaceBorrowed(iid, ppObj);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// TGenericImpl allocated from a std::pmr::memory_resource by TGenericImpl::CreateWith.
+// The resource and allocation size are kept in a header in front of the object, where
+// operator delete can still reach them after the destructor has run.
+template<class _Base, class _ThreadModel>
+class TResourceGenericImpl : public TGenericImpl<_Base, _ThreadModel>
+{
+    struct alignas(std::max_align_t) Header
+    {
+        std::pmr::memory_resource *pResource;
+        size_t Size;
+    };
+
+    static void Deallocate(void *p) noexcept
+    {
+        Header *pHeader = static_cast<Header *>(p) - 1;
+        pHeader->pResource->deallocate(pHeader, pHeader->Size, alignof(Header));
+    }
+
+public:
+    using TGenericImpl<_Base, _ThreadModel>::TGenericImpl;
+
+    static void *operator new(size_t size, std::pmr::memory_resource *pResource)
+    {
+        static_assert(alignof(TResourceGenericImpl) <= alignof(Header), "Over-aligned classes cannot be created from a memory resource");
+        size_t totalSize = sizeof(Header) + size;
+        Header *pHeader = static_cast<Header *>(pResource->allocate(totalSize, alignof(Header)));
+        pHeader->pResource = pResource;
+        pHeader->Size = totalSize;
+        return pHeader + 1;
+    }
+
+    // Used when the constructor throws
+    static void operator delete(void *p, std::pmr::memory_resource *) noexcept
+    {
+        Deallocate(p);
+    }
+
+    static void operator delete(void *p) noexcept
+    {
+        Deallocate(p);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+template<class _Base, class _OuterClass>
+struct TAggregate : public _Base
+{
+    _OuterClass *m_pOuter;
+
+    template<typename... Arguments>
+    TAggregate(_In_ _OuterClass *pOuter, Arguments&&... params) :
+        _Base(std::forward<Arguments>(params)...),
+        m_pOuter(pOuter)
+    {
+    }
+
+    // Always delegate AddRef to outer generic for proper aggregation
+    GEMMETHOD_(unsigned long,AddRef)() final
+    {
+        return m_pOuter->AddRef();
+    }
+
+    // Always delegate Release to outer generic for proper aggregation
+    GEMMETHOD_(unsigned long, Release)() final
+    {
+        return m_pOuter->Release();
+    }
+    // Delegate ALL QueryInterface calls to outer object for proper COM aggregation identity
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        // Always delegate to outer object - it knows about both outer and inner interfaces
+        return m_pOuter->QueryInterface(iid, ppObj);
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        return m_pOuter->QueryInterfaceBorrowed(iid, ppObj);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Aggregate embedded as a member of its outer class, declared with GEM_EMBEDDED_AGGREGATE.
+// Unlike TAggregate it stores no outer pointer: _Locator recovers the outer object from the
+// member offset, and AddRef/Release call the outer TGenericImpl<_OuterClass, _ThreadModel>
+// reference count directly instead of through the outer vtable.
+// The outer object must be created as TGenericImpl<_OuterClass, _ThreadModel>.
+template<class _Base, class _OuterClass, class _Locator, class _ThreadModel = DefaultThreadModel>
+struct TEmbeddedAggregate : public _Base
+{
+    using OuterImpl = TGenericImpl<_OuterClass, _ThreadModel>;
+
+    template<typename... Arguments>
+    TEmbeddedAggregate(Arguments&&... params) :
+        _Base(std::forward<Arguments>(params)...)
+    {
+    }
+
+    TEmbeddedAggregate(const TEmbeddedAggregate &) = delete;
+    TEmbeddedAggregate &operator=(const TEmbeddedAggregate &) = delete;
+
+    OuterImpl *Outer() noexcept
+    {
+        return static_cast<OuterImpl *>(_Locator::Outer(this));
+    }
+
+    GEM_REFTRACE_NOINLINE GEMMETHOD_(unsigned long,AddRef)() final
+    {
+        return Outer()->InternalAddRef(GEM_REFTRACE_CALLER());
+    }
+
+    GEM_REFTRACE_NOINLINE GEMMETHOD_(unsigned long, Release)() final
+    {
+        return Outer()->InternalRelease(GEM_REFTRACE_CALLER());
+    }
+
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        return Outer()->OuterImpl::QueryInterface(iid, ppObj);
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        return Outer()->OuterImpl::QueryInterfaceBorrowed(iid, ppObj);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Holder for an aggregate that is created on first use (see GEM_INTERFACE_ENTRY_LAZY_AGGREGATE).
+// The first query constructs TAggregate<_Base, _OuterClass>; concurrent first queries wait for it
+// rather than constructing a second one. Once built, a query is a single acquire load.
+// A failed construction leaves the holder empty so a later query can retry.
+template<class _Base, class _OuterClass>
+class TLazyAggregate
+{
+public:
+    using Aggregate = TAggregate<_Base, _OuterClass>;
+
+private:
+    static constexpr uintptr_t Building = 1;
+
+    std::atomic<uintptr_t> m_State{0};
+
+    Result Create(_OuterClass *pOuter, Aggregate **ppAggregate) noexcept
+    {
+        for (;;)
+        {
+            uintptr_t state = 0;
+            if (m_State.compare_exchange_weak(state, Building, std::memory_order_acquire, std::memory_order_acquire))
+            {
+                break;
+            }
+
+            if (state > Building)
+            {
+                *ppAggregate = reinterpret_cast<Aggregate *>(state);
+                return Result::Success;
+            }
+
+            if (state == Building)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+#if GEM_EXCEPTIONS
+        try
+        {
+            Aggregate *pAggregate = new Aggregate(pOuter); // throw std::bad_alloc
+            m_State.store(reinterpret_cast<uintptr_t>(pAggregate), std::memory_order_release);
+            *ppAggregate = pAggregate;
+            return Result::Success;
+        }
+        catch (const std::bad_alloc &)
+        {
+            m_State.store(0, std::memory_order_release);
+            return Result::OutOfMemory;
+        }
+        catch (const GemError &e)
+        {
+            m_State.store(0, std::memory_order_release);
+            return e.Result();
+        }
+#else
+        Aggregate *pAggregate = NewNoThrow<Aggregate>(pOuter);
+        m_State.store(reinterpret_cast<uintptr_t>(pAggregate), std::memory_order_release);
+        *ppAggregate = pAggregate;
+        return pAggregate ? Result::Success : Result::OutOfMemory;
+#endif
+    }
+
+public:
+    TLazyAggregate() = default;
+    TLazyAggregate(const TLazyAggregate &) = delete;
+    TLazyAggregate &operator=(const TLazyAggregate &) = delete;
+
+    ~TLazyAggregate()
+    {
+        delete Get();
+    }
+
+    // Returns the aggregate if it has been created
+    Aggregate *Get() const noexcept
+    {
+        uintptr_t state = m_State.load(std::memory_order_acquire);
+        return state > Building ? reinterpret_cast<Aggregate *>(state) : nullptr;
+    }
+
+    // Returns _XFace on the aggregate, creating the aggregate if needed. Does not AddRef.
+    template<class _XFace>
+    Result Acquire(_In_ _OuterClass *pOuter, _Outptr_result_nullonfailure_ _XFace **ppObj) noexcept
+    {
+        Aggregate *pAggregate = Get();
+        if (!pAggregate)
+        {
+            Result result = Create(pOuter, &pAggregate);
+            if (Failed(result))
+            {
+                *ppObj = nullptr;
+                return result;
+            }
+        }
+
+        *ppObj = static_cast<_XFace *>(pAggregate);
+        return Result::Success;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Owner-side record of a cached tear-off (see GEM_INTERFACE_ENTRY_CACHED_TEAROFF). Holds the
+// live tear-off, if any, without a reference; the tear-off clears it when it is destroyed.
+// The low bit of the state is a spin lock serializing lookup against the final Release.
+class TearOffSlot
+{
+    static constexpr uintptr_t LockBit = 1;
+
+    std::atomic<uintptr_t> m_State{0};
+
+public:
+    TearOffSlot() = default;
+    TearOffSlot(const TearOffSlot &) = delete;
+    TearOffSlot &operator=(const TearOffSlot &) = delete;
+
+    // Returns the recorded tear-off
+    void *Lock() noexcept
+    {
+        for (;;)
+        {
+            uintptr_t state = m_State.load(std::memory_order_relaxed);
+            if (!(state & LockBit) &&
+                m_State.compare_exchange_weak(state, state | LockBit, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return reinterpret_cast<void *>(state);
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    // Records pTearOff and releases the lock
+    void Unlock(void *pTearOff) noexcept
+    {
+        m_State.store(reinterpret_cast<uintptr_t>(pTearOff), std::memory_order_release);
+    }
+
+    // Forgets pTearOff unless another tear-off has replaced it already
+    void Remove(void *pTearOff) noexcept
+    {
+        void *pCurrent = Lock();
+        Unlock(pCurrent == pTearOff ? nullptr : pCurrent);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Base for tear-off interface implementations. A tear-off implements _XFace on behalf of an
+// _Owner object, has its own reference count and keeps the owner alive. Every other interface,
+// including XGeneric, is queried on the owner, so the owner's identity is preserved.
+//
+//     class CEditorDiagnostics : public Gem::TTearOff<XDiagnostics, CEditor>
+//     {
+//     public:
+//         using TTearOff::TTearOff;
+//         GEMMETHODIMP(Dump)() override { return Owner()->DumpState(); }
+//     };
+template<class _XFace, class _Owner>
+class TTearOff : public _XFace
+{
+    std::atomic<unsigned long> m_RefCount{1};
+    _Owner *m_pOwner;
+    TearOffSlot *m_pSlot = nullptr;
+
+    template<class _TearOffImpl, class _OwnerClass>
+    friend Result QueryTearOff(_OwnerClass *, TearOffSlot *, typename _TearOffImpl::TearOffInterface **) noexcept;
+
+    // Adds a reference unless the count has already dropped to zero
+    bool TryAddRef() noexcept
+    {
+        unsigned long count = m_RefCount.load(std::memory_order_relaxed);
+        while (count != 0)
+        {
+            if (m_RefCount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+public:
+    using TearOffInterface = _XFace;
+    using TearOffBase = TTearOff;
+
+    explicit TTearOff(_In_ _Owner *pOwner) :
+        m_pOwner(pOwner)
+    {
+        m_pOwner->AddRef();
+    }
+
+    virtual ~TTearOff() = default;
+
+    _Owner *Owner() const { return m_pOwner; }
+
+    GEMMETHOD_(unsigned long, AddRef)() final
+    {
+        return m_RefCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    GEMMETHOD_(unsigned long, Release)() final
+    {
+        unsigned long result = m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (0UL == result)
+        {
+            if (m_pSlot)
+            {
+                m_pSlot->Remove(this);
+            }
+
+            _Owner *pOwner = m_pOwner;
+            delete(this);
+            pOwner->Release();
+        }
+
+        return result;
+    }
+
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if (iid == _XFace::IId)
+        {
+            *ppObj = static_cast<_XFace *>(this);
+            AddRef();
+            return Gem::Result::Success;
+        }
+
+        return m_pOwner->QueryInterface(iid, ppObj);
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if (iid == _XFace::IId)
+        {
+            *ppObj = static_cast<_XFace *>(this);
+            return Gem::Result::Success;
+        }
+
+        return m_pOwner->QueryInterfaceBorrowed(iid, ppObj);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Returns a referenced _TearOffImpl for pOwner, reusing the one recorded in pSlot if it is
+// still alive. Used by the tear-off interface map entries.
+template<class _TearOffImpl, class _OwnerClass>
+Result QueryTearOff(_In_ _OwnerClass *pOwner, TearOffSlot *pSlot, _Outptr_result_nullonfailure_ typename _TearOffImpl::TearOffInterface **ppObj) noexcept
+{
+    using TearOffBase = typename _TearOffImpl::TearOffBase;
+
+    *ppObj = nullptr;
+
+    void *pCached = pSlot ? pSlot->Lock() : nullptr;
+    if (pCached && static_cast<TearOffBase *>(pCached)->TryAddRef())
+    {
+        pSlot->Unlock(pCached);
+        *ppObj = static_cast<TearOffBase *>(pCached);
+        return Result::Success;
+    }
+
+    Result result = Result::Success;
+#if GEM_EXCEPTIONS
+    try
+    {
+        TearOffBase *pTearOff = new _TearOffImpl(pOwner); // throw std::bad_alloc
+        pTearOff->m_pSlot = pSlot;
+        pCached = pTearOff;
+        *ppObj = pTearOff;
+    }
+    catch (const std::bad_alloc &)
+    {
+        result = Result::OutOfMemory;
+    }
+    catch (const GemError &e)
+    {
+        result = e.Result();
+    }
+#else
+    if (TearOffBase *pTearOff = NewNoThrow<_TearOffImpl>(pOwner))
+    {
+        pTearOff->m_pSlot = pSlot;
+        pCached = pTearOff;
+        *ppObj = pTearOff;
+    }
+    else
+    {
+        result = Result::OutOfMemory;
+    }
+#endif
+
+    if (pSlot)
+    {
+        pSlot->Unlock(pCached);
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------------
+// Custom interfaces must derive from TGeneric<_Xface>
+template<class _Xface>
+class TGeneric : public _Xface
+{
+public:
+    virtual ~TGeneric() = default;
+    GEMMETHOD(InternalQueryInterface)(Gem::InterfaceId /*iid*/, _Outptr_result_nullonfailure_ void **ppUnk)
+    {
+        *ppUnk = nullptr;
+        return Gem::Result::NoInterface;
+    }
+
+    GEMMETHOD(InternalQueryInterfaceBorrowed)(Gem::InterfaceId /*iid*/, _Outptr_result_nullonfailure_ void **ppUnk)
+    {
+        *ppUnk = nullptr;
+        return Gem::Result::NoInterface;
+    }
+
+    virtual void Uninitialize() {}
+};
+
+//------------------------------------------------------------------------------------------------
+// Per-call-site inline cache for borrowed queries of _XFace. The first query on an object of a
+// given concrete class goes through QueryInterfaceBorrowed; the resulting pointer adjustment is
+// remembered under the object's vtable pointer, so later queries on objects of the same class
+// skip the virtual call. Up to _Ways classes are cached; further classes always take the slow path.
+//
+// Borrowed queries only lend interfaces stored inside the object (GEM_INTERFACE_ENTRY entries and
+// member aggregates), so every cached adjustment holds for all objects of the class. Interfaces
+// implemented by separately allocated objects are never cached: TryAs fails for them, and
+// QueryInterface falls back to the object's own QueryInterface.
+//
+//     static Gem::TQueryCache<XRenderable> s_renderableCache;
+//     if (auto pRenderable = s_renderableCache.TryAs(pNode)) ...
+template<class _XFace, size_t _Ways = 4>
+class TQueryCache
+{
+    struct Entry
+    {
+        std::atomic<const void *> pVTable{nullptr};
+        std::atomic<ptrdiff_t> Adjustment{0};
+    };
+
+    Entry m_Entries[_Ways];
+    std::atomic<size_t> m_Count{0};
+    std::mutex m_Mutex;
+
+    static const void *VTableOf(const void *pObj) noexcept
+    {
+        return *static_cast<const void *const *>(pObj);
+    }
+
+    void Insert(const void *pVTable, ptrdiff_t adjustment)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        size_t count = m_Count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (m_Entries[i].pVTable.load(std::memory_order_relaxed) == pVTable)
+            {
+                return;
+            }
+        }
+
+        if (count < _Ways)
+        {
+            m_Entries[count].pVTable.store(pVTable, std::memory_order_relaxed);
+            m_Entries[count].Adjustment.store(adjustment, std::memory_order_relaxed);
+            m_Count.store(count + 1, std::memory_order_release);
+        }
+    }
+
+public:
+    // Borrowed query; the result is valid only while the caller holds a reference to pObj
+    template<class _From>
+    TGemRef<_XFace> TryAs(_From *pObj)
+    {
+        if (!pObj)
+        {
+            return TGemRef<_XFace>();
+        }
+
+        const void *pVTable = VTableOf(pObj);
+        char *pBytes = reinterpret_cast<char *>(pObj);
+        size_t count = m_Count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (m_Entries[i].pVTable.load(std::memory_order_relaxed) == pVTable)
+            {
+                return TGemRef<_XFace>(reinterpret_cast<_XFace *>(pBytes + m_Entries[i].Adjustment.load(std::memory_order_relaxed)));
+            }
+        }
+
+        void *pFound = nullptr;
+        if (Failed(pObj->QueryInterfaceBorrowed(_XFace::IId, &pFound)))
+        {
+            return TGemRef<_XFace>();
+        }
+
+        Insert(pVTable, static_cast<char *>(pFound) - pBytes);
+        return TGemRef<_XFace>(static_cast<_XFace *>(pFound));
+    }
+
+    // Owning query; AddRefs the returned interface like QueryInterface. Interfaces a borrowed
+    // query cannot lend (tear-offs, lazy aggregates, aggregates held by pointer) are queried
+    // through pObj->QueryInterface on every call.
+    template<class _From>
+    Gem::Result QueryInterface(_From *pObj, _Outptr_result_nullonfailure_ _XFace **ppObj)
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        *ppObj = TryAs(pObj);
+        if (!*ppObj)
+        {
+            return pObj ? pObj->QueryInterface(_XFace::IId, reinterpret_cast<void **>(ppObj)) : Gem::Result::BadPointer;
+        }
+
+        (*ppObj)->AddRef();
+        return Gem::Result::Success;
+    }
 };
 
 }
@@ -0,0 +1,299 @@
+//================================================================================================
+// GeM (Generic Model) - Atomic interface pointer
+//
+// TAtomicGemPtr publishes an object to concurrent readers, e.g. a configuration or routing
+// table that is replaced occasionally and read on every request:
+// - Load returns a referenced TGemPtr and is wait-free: a fixed number of atomic operations
+//   regardless of what writers do
+// - Store, Exchange and CompareExchange replace the object and wait for readers that may
+//   still be taking a reference to the old one before releasing it
+//
+// Readers protect the pointer they are about to AddRef with a per-thread slot (a hazard
+// pointer). Before a reader has read the pointer, its slot only announces the read, tagged with
+// the slot's read count, and names the TAtomicGemPtr it is reading; a writer that finds such a
+// slot completes that exact read on the reader's behalf by handing it a referenced copy of the
+// value current at that moment. So a reader never has to retry, and never sees a value older
+// than one it has already loaded.
+//================================================================================================
+
+#pragma once
+
+#include "Gem.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+// Per-thread reader slots shared by all TAtomicGemPtr instances. Slots are never freed; a slot
+// released by an exiting thread is reused by the next thread that reads.
+class AtomicGemPtrReaders
+{
+public:
+    // Slot values: 0 when idle, (read count << 1) | AnnounceFlag while a read is announced, and
+    // otherwise a protected or handed-over object pointer (or NullValue). The read count makes
+    // every announcement distinct, so a writer cannot complete a later read than the one it saw.
+    static constexpr uintptr_t AnnounceFlag = 1;
+    static constexpr uintptr_t NullValue = 2;
+
+    // Cache-line aligned so readers on different threads do not share a line
+    struct alignas(64) Slot
+    {
+        std::atomic<uintptr_t> Value{0};
+        std::atomic<const void *> pTarget{nullptr};     // The TAtomicGemPtr being read
+        uintptr_t ReadCount = 0;                        // Only used by the owning thread
+        std::atomic<bool> InUse{true};
+        Slot *pNext = nullptr;
+
+        // Announces a read of pTarget and returns the announcement
+        uintptr_t Announce(const void *pReadTarget) noexcept
+        {
+            // Written before the announcement, so a writer that sees the announcement sees it
+            pTarget.store(pReadTarget, std::memory_order_relaxed);
+            uintptr_t announcement = (++ReadCount << 1) | AnnounceFlag;
+            Value.store(announcement, std::memory_order_seq_cst);
+            return announcement;
+        }
+    };
+
+private:
+    static inline std::atomic<Slot *> s_pHead{nullptr};
+
+    struct ThreadSlot
+    {
+        Slot *pSlot;
+
+        ThreadSlot() :
+            pSlot(Claim())
+        {
+        }
+
+        ~ThreadSlot()
+        {
+            pSlot->Value.store(0, std::memory_order_relaxed);
+            pSlot->InUse.store(false, std::memory_order_release);
+        }
+    };
+
+    static Slot *Claim()
+    {
+        for (Slot *pSlot = s_pHead.load(std::memory_order_acquire); pSlot; pSlot = pSlot->pNext)
+        {
+            bool inUse = false;
+            if (pSlot->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+            {
+                return pSlot;
+            }
+        }
+
+        Slot *pSlot = new Slot;
+        Slot *pHead = s_pHead.load(std::memory_order_relaxed);
+        do
+        {
+            pSlot->pNext = pHead;
+        } while (!s_pHead.compare_exchange_weak(pHead, pSlot, std::memory_order_release, std::memory_order_relaxed));
+
+        return pSlot;
+    }
+
+public:
+    // The calling thread's slot; the first call on a thread claims one
+    static Slot &ThisThread()
+    {
+        static thread_local ThreadSlot slot;
+        return *slot.pSlot;
+    }
+
+    static Slot *First() noexcept
+    {
+        return s_pHead.load(std::memory_order_acquire);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Atomically replaceable TGemPtr<_Type>. The object must not be read through the TAtomicGemPtr
+// while the TAtomicGemPtr itself is being destroyed.
+template<class _Type>
+class TAtomicGemPtr
+{
+    using Readers = AtomicGemPtrReaders;
+
+    std::atomic<_Type *> m_p{nullptr};
+
+    // Returns the current object with a new reference. The object is protected by slot, which
+    // must be the calling thread's idle slot, until the reference has been taken.
+    _Type *LoadProtected(Readers::Slot &slot) const noexcept
+    {
+        _Type *p = m_p.load(std::memory_order_seq_cst);
+        for (;;)
+        {
+            slot.Value.store(p ? reinterpret_cast<uintptr_t>(p) : Readers::NullValue, std::memory_order_seq_cst);
+            _Type *pCurrent = m_p.load(std::memory_order_seq_cst);
+            if (pCurrent == p)
+            {
+                break;
+            }
+
+            p = pCurrent;
+        }
+
+        if (p)
+        {
+            p->AddRef();
+        }
+
+        slot.Value.store(0, std::memory_order_release);
+        return p;
+    }
+
+    // Called after pOld (referenced by the caller) was replaced: completes the reads announced on
+    // this pointer and waits until no reader is still protecting pOld. writerSlot is the calling
+    // thread's slot.
+    void Retire(_Type *pOld, Readers::Slot &writerSlot) noexcept
+    {
+        for (Readers::Slot *pSlot = Readers::First(); pSlot; pSlot = pSlot->pNext)
+        {
+            for (;;)
+            {
+                uintptr_t value = pSlot->Value.load(std::memory_order_seq_cst);
+                if (value & Readers::AnnounceFlag)
+                {
+                    // The target cannot change until the read announced by value completes
+                    if (pSlot->pTarget.load(std::memory_order_relaxed) != this)
+                    {
+                        break;
+                    }
+
+                    // Hand over the value current now, not the one this writer stored: a later
+                    // writer may already have replaced it, and the reader may have seen that.
+                    // The exchange fails if the announced read completed in the meantime.
+                    _Type *pCurrent = LoadProtected(writerSlot);
+                    uintptr_t handed = pCurrent ? reinterpret_cast<uintptr_t>(pCurrent) : Readers::NullValue;
+                    if (pSlot->Value.compare_exchange_strong(value, handed, std::memory_order_seq_cst))
+                    {
+                        break;
+                    }
+
+                    if (pCurrent)
+                    {
+                        pCurrent->Release();
+                    }
+                    continue;
+                }
+
+                if (pOld && value == reinterpret_cast<uintptr_t>(pOld))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                break;
+            }
+        }
+
+        if (pOld)
+        {
+            pOld->Release();
+        }
+    }
+
+public:
+    TAtomicGemPtr() = default;
+    TAtomicGemPtr(_Type *p) :
+        m_p(p)
+    {
+        if (p)
+        {
+            p->AddRef();
+        }
+    }
+
+    TAtomicGemPtr(const TAtomicGemPtr &) = delete;
+    TAtomicGemPtr &operator=(const TAtomicGemPtr &) = delete;
+
+    ~TAtomicGemPtr()
+    {
+        _Type *p = m_p.load(std::memory_order_relaxed);
+        if (p)
+        {
+            p->Release();
+        }
+    }
+
+    // Wait-free: returns the current object with a new reference
+    TGemPtr<_Type> Load() const
+    {
+        Readers::Slot &slot = Readers::ThisThread();
+        uintptr_t announcement = slot.Announce(this);
+
+        _Type *p = m_p.load(std::memory_order_seq_cst);
+        uintptr_t value = announcement;
+        uintptr_t protectedValue = p ? reinterpret_cast<uintptr_t>(p) : Readers::NullValue;
+
+        TGemPtr<_Type> pResult;
+        if (slot.Value.compare_exchange_strong(value, protectedValue, std::memory_order_seq_cst))
+        {
+            // p is protected by the slot until the reference has been taken
+            pResult = p;
+        }
+        else if (value != Readers::NullValue)
+        {
+            // A writer completed the read and handed over a referenced object
+            pResult.Attach(reinterpret_cast<_Type *>(value));
+        }
+
+        slot.Value.store(0, std::memory_order_release);
+        return pResult;
+    }
+
+    // Replaces the object and returns the previous one
+    TGemPtr<_Type> Exchange(_Type *p)
+    {
+        Readers::Slot &writerSlot = Readers::ThisThread();
+        if (p)
+        {
+            p->AddRef();
+        }
+
+        _Type *pOld = m_p.exchange(p, std::memory_order_seq_cst);
+
+        TGemPtr<_Type> pResult = pOld;
+        Retire(pOld, writerSlot);
+        return pResult;
+    }
+
+    void Store(_Type *p)
+    {
+        Exchange(p);
+    }
+
+    // Replaces the object with pDesired if it is still pExpected. On failure, pExpected is
+    // updated to the current object.
+    bool CompareExchange(TGemPtr<_Type> &pExpected, _Type *pDesired)
+    {
+        Readers::Slot &writerSlot = Readers::ThisThread();
+        if (pDesired)
+        {
+            pDesired->AddRef();
+        }
+
+        _Type *pOld = pExpected.Get();
+        if (m_p.compare_exchange_strong(pOld, pDesired, std::memory_order_seq_cst))
+        {
+            Retire(pOld, writerSlot);
+            return true;
+        }
+
+        if (pDesired)
+        {
+            pDesired->Release();
+        }
+
+        pExpected = Load();
+        return false;
+    }
+};
+
+}
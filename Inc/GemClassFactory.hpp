@@ -0,0 +1,407 @@
+//================================================================================================
+// GeM (Generic Model) - Class factories and the class registry
+//
+// Creates objects by class id, for composition roots that pick implementations from
+// configuration:
+// - XClassFactory creates instances of one class
+// - GEM_REGISTER_CLASS registers a TGenericImpl-based class under a class id during static
+//   initialization
+// - Gem::CreateInstance(ClassId, InterfaceId, void **) looks the class up and creates it
+//
+// Registration is open until ClassRegistry::Freeze, typically called once at the end of
+// startup. Freeze builds a perfect hash table over the registered ids and publishes it; from
+// then on lookups take no lock and cost two hashes and one compare.
+//================================================================================================
+
+#pragma once
+
+#include "Gem.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Registers class cls, created through TGenericImpl<cls>, under clsid. Use at namespace scope
+// in one translation unit. Use the _TM form to instantiate cls with a non-default threading model.
+#define GEM_REGISTER_CLASS(clsid, cls) \
+    GEM_REGISTER_CLASS_TM(clsid, cls, Gem::DefaultThreadModel)
+
+#define GEM_REGISTER_CLASS_TM(clsid, cls, threadModel) \
+    [[maybe_unused]] static const Gem::Result GEM_CLASS_REGISTRATION_NAME(__LINE__) = \
+        Gem::ClassRegistry::Register(clsid, &Gem::TClassFactory<cls, threadModel>::Instance())
+
+#define GEM_CLASS_REGISTRATION_NAME(line) GEM_CLASS_REGISTRATION_NAME_(line)
+#define GEM_CLASS_REGISTRATION_NAME_(line) gemClassRegistration##line
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+// 64-bit class identifier
+struct ClassId
+{
+	const uint64_t Value;
+	ClassId() = default;
+	constexpr ClassId(const ClassId& o) = default;
+	constexpr ClassId(uint64_t i) :
+		Value(i) {}
+	constexpr bool operator==(const ClassId& o) const { return Value == o.Value; }
+	constexpr bool operator==(uint64_t v) const { return Value == v; }
+	constexpr operator uint64_t() const { return Value; }
+};
+
+//------------------------------------------------------------------------------------------------
+// Creates instances of a single class
+struct XClassFactory : public XGeneric
+{
+    GEM_INTERFACE_DECLARE(XClassFactory, 0xfffffffffffffffcU);
+
+    // Creates a new instance and returns its iid interface with one reference
+    GEMMETHOD(CreateInstance)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// Class factory for TGenericImpl<_Class, _ThreadModel>. There is a single static instance per
+// class, so AddRef and Release do not count.
+template<class _Class, class _ThreadModel = DefaultThreadModel>
+class TClassFactory final : public XClassFactory
+{
+    TClassFactory() = default;
+
+public:
+    static TClassFactory &Instance() noexcept
+    {
+        static TClassFactory s_Factory;
+        return s_Factory;
+    }
+
+    GEMMETHOD_(unsigned long, AddRef)() final
+    {
+        return 1;
+    }
+
+    GEMMETHOD_(unsigned long, Release)() final
+    {
+        return 1;
+    }
+
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        return QueryInterfaceBorrowed(iid, ppObj);
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if (iid == XGeneric::IId || iid == XClassFactory::IId)
+        {
+            *ppObj = static_cast<XClassFactory *>(this);
+            return Gem::Result::Success;
+        }
+
+        *ppObj = nullptr;
+        return Gem::Result::NoInterface;
+    }
+
+    GEMMETHOD(CreateInstance)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        *ppObj = nullptr;
+
+        _Class *pObj = nullptr;
+        Result result = TGenericImpl<_Class, _ThreadModel>::Create(&pObj);
+        if (Failed(result))
+        {
+            return result;
+        }
+
+        // A borrowed interface shares the object's count, so the creation reference carries over
+        // and no AddRef/Release pair is needed. Tear-offs cannot be borrowed and take the slow path.
+        result = pObj->QueryInterfaceBorrowed(iid, ppObj);
+        if (Failed(result))
+        {
+            result = pObj->QueryInterface(iid, ppObj);
+            pObj->Release();
+        }
+
+        return result;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Process-wide map from class id to class factory. Factories are not referenced by the
+// registry and must outlive it (static factories do).
+class ClassRegistry
+{
+    struct Entry
+    {
+        uint64_t Id = 0;
+        XClassFactory *pFactory = nullptr;
+    };
+
+    // Hash-and-displace perfect hash: each id hashes to a bucket, and the bucket's seed places
+    // all of its ids in distinct slots. Immutable once published.
+    struct Table
+    {
+        uint64_t BucketMask = 0;
+        uint64_t SlotMask = 0;
+        std::vector<uint32_t> Seeds;
+        std::vector<Entry> Slots;
+    };
+
+    struct State
+    {
+        std::mutex Mutex;
+        std::vector<Entry> Entries;
+    };
+
+    static constexpr uint32_t MaxSeedAttempts = 1u << 16;
+
+    static inline std::atomic<const Table *> s_pTable{nullptr};
+
+    static State &GetState()
+    {
+        // Intentionally leaked so registrations from other static initializers and lookups from
+        // static destructors stay valid
+        static State *pState = new State;
+        return *pState;
+    }
+
+    static uint64_t Mix(uint64_t value) noexcept
+    {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        value ^= value >> 31;
+        return value;
+    }
+
+    static uint64_t BucketOf(const Table &table, uint64_t id) noexcept
+    {
+        return (Mix(id) >> 32) & table.BucketMask;
+    }
+
+    static uint64_t SlotOf(const Table &table, uint64_t id, uint32_t seed) noexcept
+    {
+        return Mix(id + (uint64_t(seed) + 1) * 0x9e3779b97f4a7c15ULL) & table.SlotMask;
+    }
+
+    static uint64_t RoundUpPow2(uint64_t value) noexcept
+    {
+        uint64_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    // Returns false if some bucket has no seed that fits it into the free slots
+    static bool TryBuild(Table &table, const std::vector<Entry> &entries)
+    {
+        std::vector<std::vector<const Entry *>> buckets(table.BucketMask + 1);
+        for (const Entry &entry : entries)
+        {
+            buckets[BucketOf(table, entry.Id)].push_back(&entry);
+        }
+
+        // Largest buckets first, while most slots are still free
+        std::vector<uint64_t> order(buckets.size());
+        for (uint64_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b)
+        {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        table.Seeds.assign(buckets.size(), 0);
+        table.Slots.assign(table.SlotMask + 1, Entry{});
+        std::vector<uint64_t> slots;
+        for (uint64_t bucketIndex : order)
+        {
+            const std::vector<const Entry *> &bucket = buckets[bucketIndex];
+            if (bucket.empty())
+            {
+                break;
+            }
+
+            uint32_t seed = 0;
+            for (;; ++seed)
+            {
+                if (seed == MaxSeedAttempts)
+                {
+                    return false;
+                }
+
+                slots.clear();
+                for (const Entry *pEntry : bucket)
+                {
+                    uint64_t slot = SlotOf(table, pEntry->Id, seed);
+                    if (table.Slots[slot].pFactory || std::find(slots.begin(), slots.end(), slot) != slots.end())
+                    {
+                        break;
+                    }
+
+                    slots.push_back(slot);
+                }
+
+                if (slots.size() == bucket.size())
+                {
+                    break;
+                }
+            }
+
+            table.Seeds[bucketIndex] = seed;
+            for (size_t i = 0; i < bucket.size(); ++i)
+            {
+                table.Slots[slots[i]] = *bucket[i];
+            }
+        }
+
+        return true;
+    }
+
+public:
+    // Adds a class. Fails with InvalidArg if clsid is already registered to another factory,
+    // and with Unavailable once the registry is frozen.
+    static Result Register(ClassId clsid, _In_ XClassFactory *pFactory)
+    {
+        if (!pFactory)
+        {
+            return Result::BadPointer;
+        }
+
+        State &state = GetState();
+        std::lock_guard<std::mutex> lock(state.Mutex);
+        if (s_pTable.load(std::memory_order_relaxed))
+        {
+            return Result::Unavailable;
+        }
+
+        for (const Entry &entry : state.Entries)
+        {
+            if (entry.Id == clsid)
+            {
+                return entry.pFactory == pFactory ? Result::Success : Result::InvalidArg;
+            }
+        }
+
+        state.Entries.push_back({clsid, pFactory});
+        return Result::Success;
+    }
+
+    // Ends registration and publishes the perfect hash table. Later calls do nothing.
+    static void Freeze()
+    {
+        State &state = GetState();
+        std::lock_guard<std::mutex> lock(state.Mutex);
+        if (s_pTable.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        // Slots at most 4/5 full and about two ids per bucket keep the seed search short
+        uint64_t count = state.Entries.size();
+        Table *pTable = new Table;
+        pTable->BucketMask = RoundUpPow2(std::max<uint64_t>(1, count / 2)) - 1;
+        pTable->SlotMask = RoundUpPow2(std::max<uint64_t>(1, count + count / 4)) - 1;
+        while (!TryBuild(*pTable, state.Entries))
+        {
+            pTable->SlotMask = pTable->SlotMask * 2 + 1;
+        }
+
+        state.Entries.clear();
+        state.Entries.shrink_to_fit();
+
+        // Never freed; lookups may still be running on other threads
+        s_pTable.store(pTable, std::memory_order_release);
+    }
+
+    static bool IsFrozen() noexcept
+    {
+        return s_pTable.load(std::memory_order_acquire) != nullptr;
+    }
+
+    // Returns the factory registered for clsid, or nullptr. Lock-free once frozen.
+    static XClassFactory *Find(ClassId clsid)
+    {
+        if (const Table *pTable = s_pTable.load(std::memory_order_acquire))
+        {
+            const Entry &entry = pTable->Slots[SlotOf(*pTable, clsid, pTable->Seeds[BucketOf(*pTable, clsid)])];
+            return entry.Id == clsid ? entry.pFactory : nullptr;
+        }
+
+        State &state = GetState();
+        std::lock_guard<std::mutex> lock(state.Mutex);
+        for (const Entry &entry : state.Entries)
+        {
+            if (entry.Id == clsid)
+            {
+                return entry.pFactory;
+            }
+        }
+
+        // Frozen while waiting for the lock
+        if (s_pTable.load(std::memory_order_relaxed))
+        {
+            return Find(clsid);
+        }
+
+        return nullptr;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Creates an instance of the class registered under clsid and returns its iid interface
+inline Result CreateInstance(ClassId clsid, InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj)
+{
+    if (!ppObj)
+    {
+        return Result::BadPointer;
+    }
+
+    *ppObj = nullptr;
+
+    XClassFactory *pFactory = ClassRegistry::Find(clsid);
+    if (!pFactory)
+    {
+        return Result::NotFound;
+    }
+
+    return pFactory->CreateInstance(iid, ppObj);
+}
+
+//------------------------------------------------------------------------------------------------
+// Returns the factory registered for clsid
+inline Result GetClassFactory(ClassId clsid, _Outptr_result_nullonfailure_ XClassFactory **ppFactory)
+{
+    if (!ppFactory)
+    {
+        return Result::BadPointer;
+    }
+
+    *ppFactory = ClassRegistry::Find(clsid);
+    if (!*ppFactory)
+    {
+        return Result::NotFound;
+    }
+
+    (*ppFactory)->AddRef();
+    return Result::Success;
+}
+
+}
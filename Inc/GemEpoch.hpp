@@ -0,0 +1,366 @@
+//================================================================================================
+// GeM (Generic Model) - Epoch-based deferred release
+//
+// For read-mostly object graphs shared across many threads:
+// - Readers traverse the graph with raw pointers inside an EpochReadGuard, with no AddRef or
+//   Release on the nodes they visit
+// - Writers unlink a node, then hand their reference to GemRetire instead of releasing it
+// - The reference is released once every reader that could still see the node has left its
+//   read-side section, so the node is uninitialized and destroyed as usual by its final Release
+//
+// Retired references are kept per thread and released by GemReclaim, which GemRetire also runs
+// every RetireBatch retirements. GemSynchronize waits for all current readers and then releases
+// everything the calling thread has retired.
+//
+// If a retirement cannot be recorded for lack of memory, GemRetire waits for the readers like
+// GemSynchronize. Inside a read guard that would wait for the caller itself, so the reference is
+// kept in a small preallocated per-thread overflow list instead. Releasing retired references
+// allocates nothing, so reclaiming still works when memory is exhausted.
+//================================================================================================
+
+#pragma once
+
+#include "Gem.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+class EpochDomain
+{
+public:
+    static constexpr size_t RetireBatch = 64;
+
+    // Retirements a thread can defer inside a read guard when its retire list cannot grow
+    static constexpr size_t OverflowCapacity = 16;
+
+private:
+    // A thread's announced epoch; 0 while it is outside any read-side section
+    struct alignas(64) Record
+    {
+        std::atomic<uint64_t> Epoch{0};
+        std::atomic<bool> InUse{true};
+        Record *pNext = nullptr;
+    };
+
+    struct Retired
+    {
+        XGeneric *pObj;
+        uint64_t Epoch;
+    };
+
+    struct ThreadState
+    {
+        Record *pRecord;
+        unsigned Nesting = 0;
+        bool Releasing = false;
+        std::vector<Retired> RetiredList;
+        std::array<Retired, OverflowCapacity> Overflow;
+        size_t OverflowCount = 0;
+
+        ThreadState() :
+            pRecord(Claim())
+        {
+        }
+
+        // References still waiting for readers are handed to the next thread that reclaims
+        ~ThreadState()
+        {
+            if (!RetiredList.empty() || OverflowCount)
+            {
+                std::lock_guard<std::mutex> lock(OrphanMutex());
+                Orphans().insert(Orphans().end(), RetiredList.begin(), RetiredList.end());
+                Orphans().insert(Orphans().end(), Overflow.begin(), Overflow.begin() + OverflowCount);
+            }
+
+            pRecord->Epoch.store(0, std::memory_order_relaxed);
+            pRecord->InUse.store(false, std::memory_order_release);
+        }
+    };
+
+    static inline std::atomic<uint64_t> s_Epoch{1};
+    static inline std::atomic<Record *> s_pRecords{nullptr};
+
+    static std::mutex &OrphanMutex()
+    {
+        static std::mutex *pMutex = new std::mutex;
+        return *pMutex;
+    }
+
+    static std::vector<Retired> &Orphans()
+    {
+        static std::vector<Retired> *pOrphans = new std::vector<Retired>;
+        return *pOrphans;
+    }
+
+    static Record *Claim()
+    {
+        for (Record *pRecord = s_pRecords.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+        {
+            bool inUse = false;
+            if (pRecord->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+            {
+                return pRecord;
+            }
+        }
+
+        Record *pRecord = new Record;
+        Record *pHead = s_pRecords.load(std::memory_order_relaxed);
+        do
+        {
+            pRecord->pNext = pHead;
+        } while (!s_pRecords.compare_exchange_weak(pHead, pRecord, std::memory_order_release, std::memory_order_relaxed));
+
+        return pRecord;
+    }
+
+    static ThreadState &ThisThread()
+    {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    // Oldest epoch announced by a reader, or the maximum if no thread is reading
+    static uint64_t OldestReader() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        for (Record *pRecord = s_pRecords.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+        {
+            uint64_t epoch = pRecord->Epoch.load(std::memory_order_acquire);
+            if (epoch != 0 && epoch < oldest)
+            {
+                oldest = epoch;
+            }
+        }
+
+        return oldest;
+    }
+
+    // Releases the entry and clears it if it was retired before epoch `before`
+    static void ReleaseIfBefore(Retired &retired, uint64_t before)
+    {
+        if (retired.Epoch < before)
+        {
+            XGeneric *pObj = retired.pObj;
+            retired.pObj = nullptr;
+            pObj->Release();
+        }
+    }
+
+    // Releases the entries retired before epoch `before` without allocating. A final Release may
+    // retire further objects onto the same lists, so entries are visited by index and cleared,
+    // and the lists are compacted afterwards; a reclaim nested in such a Release does nothing.
+    static void ReleaseBefore(uint64_t before)
+    {
+        ThreadState &state = ThisThread();
+        if (state.Releasing)
+        {
+            return;
+        }
+
+        state.Releasing = true;
+
+        size_t count = state.RetiredList.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            ReleaseIfBefore(state.RetiredList[i], before);
+        }
+
+        count = state.OverflowCount;
+        for (size_t i = 0; i < count; ++i)
+        {
+            ReleaseIfBefore(state.Overflow[i], before);
+        }
+
+        state.RetiredList.erase(std::remove_if(state.RetiredList.begin(), state.RetiredList.end(),
+            [](const Retired &retired) { return !retired.pObj; }), state.RetiredList.end());
+
+        size_t kept = 0;
+        for (size_t i = 0; i < state.OverflowCount; ++i)
+        {
+            if (state.Overflow[i].pObj)
+            {
+                state.Overflow[kept++] = state.Overflow[i];
+            }
+        }
+
+        state.OverflowCount = kept;
+
+        // Orphans are taken one at a time, so no Release runs under the orphan lock
+        for (size_t i = 0;;)
+        {
+            XGeneric *pObj = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(OrphanMutex());
+                std::vector<Retired> &orphans = Orphans();
+                for (; i < orphans.size(); ++i)
+                {
+                    if (orphans[i].Epoch < before)
+                    {
+                        pObj = orphans[i].pObj;
+                        orphans[i] = orphans.back();
+                        orphans.pop_back();
+                        break;
+                    }
+                }
+            }
+
+            if (!pObj)
+            {
+                break;
+            }
+
+            pObj->Release();
+        }
+
+        state.Releasing = false;
+    }
+
+public:
+    static void Enter() noexcept
+    {
+        ThreadState &state = ThisThread();
+        if (state.Nesting++ == 0)
+        {
+            state.pRecord->Epoch.store(s_Epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void Exit() noexcept
+    {
+        ThreadState &state = ThisThread();
+        if (--state.Nesting == 0)
+        {
+            state.pRecord->Epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    static void Retire(XGeneric *pObj)
+    {
+        if (!pObj)
+        {
+            return;
+        }
+
+        uint64_t epoch = s_Epoch.fetch_add(1, std::memory_order_seq_cst);
+
+        ThreadState &state = ThisThread();
+        std::vector<Retired> &list = state.RetiredList;
+#if GEM_EXCEPTIONS
+        try
+        {
+            list.push_back({pObj, epoch});
+        }
+        catch (const std::bad_alloc &)
+        {
+            if (state.Nesting == 0)
+            {
+                // Nowhere to defer the release; wait for the readers instead
+                Synchronize();
+                pObj->Release();
+                return;
+            }
+
+            // Synchronize would wait for this thread's own guard. Running out of overflow
+            // entries as well leaves no safe way to release the object.
+            if (state.OverflowCount == OverflowCapacity)
+            {
+                std::abort();
+            }
+
+            state.Overflow[state.OverflowCount++] = {pObj, epoch};
+            return;
+        }
+#else
+        list.push_back({pObj, epoch});
+#endif
+
+        if (list.size() % RetireBatch == 0)
+        {
+            Reclaim();
+        }
+    }
+
+    static void Reclaim()
+    {
+        ReleaseBefore(OldestReader());
+    }
+
+    static void Synchronize()
+    {
+        uint64_t epoch = s_Epoch.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        for (Record *pRecord = s_pRecords.load(std::memory_order_acquire); pRecord; pRecord = pRecord->pNext)
+        {
+            for (;;)
+            {
+                uint64_t readerEpoch = pRecord->Epoch.load(std::memory_order_acquire);
+                if (readerEpoch == 0 || readerEpoch > epoch)
+                {
+                    break;
+                }
+
+                std::this_thread::yield();
+            }
+        }
+
+        ReleaseBefore(epoch + 1);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Read-side critical section. Objects reachable when the guard is created stay alive until it
+// is destroyed, even if they are retired meanwhile. Guards nest.
+class EpochReadGuard
+{
+public:
+    EpochReadGuard() noexcept
+    {
+        EpochDomain::Enter();
+    }
+
+    ~EpochReadGuard()
+    {
+        EpochDomain::Exit();
+    }
+
+    EpochReadGuard(const EpochReadGuard &) = delete;
+    EpochReadGuard &operator=(const EpochReadGuard &) = delete;
+};
+
+//------------------------------------------------------------------------------------------------
+// Takes over the caller's reference to pObj, which must already be unreachable for new readers,
+// and releases it once no reader can still be using it
+inline void GemRetire(XGeneric *pObj)
+{
+    EpochDomain::Retire(pObj);
+}
+
+// Releases the calling thread's retired references that no reader can still be using
+inline void GemReclaim()
+{
+    EpochDomain::Reclaim();
+}
+
+// Waits until every thread has left the read-side sections it is in now, then releases all
+// references the calling thread has retired. Must not be called inside an EpochReadGuard.
+inline void GemSynchronize()
+{
+    EpochDomain::Synchronize();
+}
+
+}
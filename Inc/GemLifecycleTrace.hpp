@@ -0,0 +1,279 @@
+//================================================================================================
+// GeM (Generic Model) - Object lifecycle trace events
+//
+// Timeline instrumentation of TGenericImpl, enabled by defining GEM_ENABLE_LIFECYCLE_TRACE for
+// the whole program (e.g. with the CMake option of the same name); Gem.hpp then includes this
+// header and emits a duration event for
+// - Create / CreateWith: allocation, construction and Initialize
+// - Initialize, called from the TGenericImpl constructor
+// - Uninitialize and Destroy (destructor and deallocation), run by the final Release
+// Without the define the instrumentation is compiled out.
+//
+// Events are appended without locking to a buffer owned by the recording thread. A full buffer
+// is handed to the current LifecycleTraceSink, as is a thread's remainder when it exits or calls
+// LifecycleTracer::Flush. Events recorded after the thread's buffer has been destroyed (from
+// later thread_local destructors) go to the sink one at a time. ChromeTraceSink writes the Chrome
+// trace-event JSON format, which chrome://tracing and Perfetto load. Nothing is recorded while no
+// sink is set.
+//================================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+struct LifecycleEvent
+{
+    const char *Name;       // "Create", "Initialize", "Uninitialize" or "Destroy"
+    const char *ClassName;
+    const void *pObject;    // Address of the TGenericImpl; may already be freed
+    uint64_t StartNs;       // Steady clock (CLOCK_MONOTONIC on Linux)
+    uint64_t DurationNs;
+    uint64_t ThreadId;      // OS thread id on Linux, otherwise a process-local index
+};
+
+//------------------------------------------------------------------------------------------------
+// Receives batches of events. Calls are serialized by LifecycleTracer.
+class LifecycleTraceSink
+{
+public:
+    virtual ~LifecycleTraceSink() = default;
+    virtual void Write(const LifecycleEvent *pEvents, size_t count) = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+class LifecycleTracer
+{
+public:
+    static constexpr size_t BufferCapacity = 1024;
+
+private:
+    static inline std::atomic<LifecycleTraceSink *> s_pSink{nullptr};
+
+    static std::mutex &SinkMutex()
+    {
+        static std::mutex *pMutex = new std::mutex;
+        return *pMutex;
+    }
+
+    struct ThreadBuffer
+    {
+        LifecycleEvent Events[BufferCapacity];
+        size_t Count = 0;
+        uint64_t ThreadId = CurrentThreadId();
+
+        ~ThreadBuffer()
+        {
+            Drain(*this);
+            t_BufferDestroyed = true;
+        }
+    };
+
+    // Set when the calling thread's buffer is destroyed at thread exit. Trivially destructible,
+    // so destructors that run after the buffer's can still read it.
+    static inline thread_local bool t_BufferDestroyed = false;
+
+    static uint64_t CurrentThreadId() noexcept
+    {
+#if defined(__linux__)
+        return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+        static std::atomic<uint64_t> s_nextId{1};
+        return s_nextId.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    static ThreadBuffer &ThisThread()
+    {
+        static thread_local ThreadBuffer buffer;
+        return buffer;
+    }
+
+    static void WriteToSink(const LifecycleEvent *pEvents, size_t count)
+    {
+        std::lock_guard<std::mutex> lock(SinkMutex());
+        if (LifecycleTraceSink *pSink = s_pSink.load(std::memory_order_relaxed))
+        {
+            pSink->Write(pEvents, count);
+        }
+    }
+
+    static void Drain(ThreadBuffer &buffer)
+    {
+        if (buffer.Count == 0)
+        {
+            return;
+        }
+
+        WriteToSink(buffer.Events, buffer.Count);
+        buffer.Count = 0;
+    }
+
+public:
+    static bool Enabled() noexcept
+    {
+        return s_pSink.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    static uint64_t Now() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static void Record(const char *name, const char *className, const void *pObject, uint64_t startNs, uint64_t endNs)
+    {
+        if (t_BufferDestroyed)
+        {
+            LifecycleEvent event{name, className, pObject, startNs, endNs - startNs, CurrentThreadId()};
+            WriteToSink(&event, 1);
+            return;
+        }
+
+        ThreadBuffer &buffer = ThisThread();
+        buffer.Events[buffer.Count++] = {name, className, pObject, startNs, endNs - startNs, buffer.ThreadId};
+        if (buffer.Count == BufferCapacity)
+        {
+            Drain(buffer);
+        }
+    }
+
+    // Hands the calling thread's buffered events to the sink. Other threads hand theirs over
+    // when their buffer fills, when they call Flush and when they exit.
+    static void Flush()
+    {
+        if (!t_BufferDestroyed)
+        {
+            Drain(ThisThread());
+        }
+    }
+
+    // Sets the sink receiving events, or stops tracing with nullptr. The calling thread's
+    // buffered events go to the previous sink first. A sink must stay alive until it is replaced.
+    static void SetSink(LifecycleTraceSink *pSink)
+    {
+        Flush();
+
+        std::lock_guard<std::mutex> lock(SinkMutex());
+        s_pSink.store(pSink, std::memory_order_relaxed);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Records one event covering its own lifetime, if a sink is set when it is created
+class LifecycleScope
+{
+    const char *m_Name;
+    const char *m_ClassName;
+    const void *m_pObject;
+    uint64_t m_StartNs;
+
+public:
+    LifecycleScope(const char *name, const char *className, const void *pObject) noexcept :
+        m_Name(name),
+        m_ClassName(className),
+        m_pObject(pObject),
+        m_StartNs(LifecycleTracer::Enabled() ? LifecycleTracer::Now() : 0)
+    {
+    }
+
+    ~LifecycleScope()
+    {
+        if (m_StartNs != 0)
+        {
+            LifecycleTracer::Record(m_Name, m_ClassName, m_pObject, m_StartNs, LifecycleTracer::Now());
+        }
+    }
+
+    LifecycleScope(const LifecycleScope &) = delete;
+    LifecycleScope &operator=(const LifecycleScope &) = delete;
+};
+
+//------------------------------------------------------------------------------------------------
+// Writes events as Chrome trace-event JSON ("X" complete events, microsecond timestamps)
+class ChromeTraceSink : public LifecycleTraceSink
+{
+    std::FILE *m_pFile;
+    uint64_t m_ProcessId;
+    bool m_First = true;
+
+    void WriteString(const char *pString)
+    {
+        std::fputc('"', m_pFile);
+        for (; *pString; ++pString)
+        {
+            if (*pString == '"' || *pString == '\\')
+            {
+                std::fputc('\\', m_pFile);
+            }
+            std::fputc(*pString, m_pFile);
+        }
+        std::fputc('"', m_pFile);
+    }
+
+public:
+    // processId should match the other traces the file is loaded with; on Linux use getpid()
+    explicit ChromeTraceSink(const char *path, uint64_t processId = 1) :
+        m_pFile(std::fopen(path, "w")),
+        m_ProcessId(processId)
+    {
+        if (m_pFile)
+        {
+            std::fputs("{\"traceEvents\":[", m_pFile);
+        }
+    }
+
+    ~ChromeTraceSink() override
+    {
+        if (m_pFile)
+        {
+            std::fputs("\n]}\n", m_pFile);
+            std::fclose(m_pFile);
+        }
+    }
+
+    ChromeTraceSink(const ChromeTraceSink &) = delete;
+    ChromeTraceSink &operator=(const ChromeTraceSink &) = delete;
+
+    bool IsOpen() const noexcept
+    {
+        return m_pFile != nullptr;
+    }
+
+    void Write(const LifecycleEvent *pEvents, size_t count) override
+    {
+        if (!m_pFile)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const LifecycleEvent &event = pEvents[i];
+            std::fputs(m_First ? "\n" : ",\n", m_pFile);
+            m_First = false;
+
+            std::fputs("{\"name\":", m_pFile);
+            WriteString(event.Name);
+            std::fprintf(m_pFile, ",\"cat\":\"gem\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%llu,\"tid\":%llu,\"args\":{\"class\":",
+                static_cast<double>(event.StartNs) / 1000.0, static_cast<double>(event.DurationNs) / 1000.0,
+                static_cast<unsigned long long>(m_ProcessId), static_cast<unsigned long long>(event.ThreadId));
+            WriteString(event.ClassName);
+            std::fprintf(m_pFile, ",\"object\":\"%p\"}}", event.pObject);
+        }
+    }
+};
+
+}
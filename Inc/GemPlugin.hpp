@@ -0,0 +1,894 @@
+//================================================================================================
+// GeM (Generic Model) - Plugin modules
+//
+// Loads classes from shared libraries on demand:
+// - A plugin lists its classes with BEGIN_GEM_PLUGIN_CLASS_MAP, which exports the module's
+//   class factory entry point and its live object count
+// - The host registers each module with PluginLoader::RegisterModule, naming the class ids it
+//   provides. Nothing is loaded yet; the class ids are added to the ClassRegistry.
+// - The first Gem::CreateInstance for one of those ids loads the module
+// - PluginLoader::UnloadUnusedModules unloads modules with no live objects
+// - With GEM_ENABLE_OBJECT_TRACKING, a loaded module records its classes in the host's
+//   TrackingRegistry, and frees those records before it is unloaded
+//
+// Load failures are reported as Result::PluginLoadFailed, and modules missing an entry point as
+// Result::PluginProcNotFound. A failed load is retried on the next request.
+//
+// PluginLoader::WarmUp loads all registered modules up front on a pool of threads, loading
+// the modules a module requires before it. The loader learns a module's required classes only
+// from a manifest (see GemPluginManifest.hpp) or from Module::AddRequiredClass; it does not open
+// a module to read GEM_PLUGIN_REQUIRED_CLASSES.
+//
+// Build plugins with hidden default visibility (-fvisibility=hidden) so their copies of the
+// GeM inline functions and statics are not bound to the host's.
+//================================================================================================
+
+#pragma once
+
+#include "Gem.hpp"
+#include "GemClassFactory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+    #define GEM_PLUGIN_EXPORT __declspec(dllexport)
+    #define GEM_PLUGIN_LOCAL
+#else
+    #include <dlfcn.h>
+    #define GEM_PLUGIN_EXPORT __attribute__((visibility("default")))
+    #define GEM_PLUGIN_LOCAL __attribute__((visibility("hidden")))
+#endif
+
+// Use BEGIN_GEM_PLUGIN_CLASS_MAP() once per plugin module, in one of its source files
+// The map exports the entry points PluginLoader resolves: GemPluginGetClassFactory, which
+// returns the factory for a class id, GemPluginObjectCount, which reports live objects,
+// GemPluginGetClassInfo, which lists the classes for manifest scanners (see GemPluginManifest.hpp),
+// and GemPluginAttach and GemPluginDetach, which connect the module to the host on load and unload.
+#define BEGIN_GEM_PLUGIN_CLASS_MAP() \
+    static const Gem::PluginClassInfo *GemPluginClassMap(size_t *pCount) { \
+    static const Gem::PluginClassInfo s_Classes[] = { \
+
+// Add a class created as TGenericImpl<cls> to the plugin class map. The optional trailing
+// arguments list the interfaces the class advertises in plugin manifests.
+#define GEM_PLUGIN_CLASS_ENTRY(clsid, cls, ...) \
+    GEM_PLUGIN_CLASS_ENTRY_TM(clsid, cls, Gem::DefaultThreadModel, __VA_ARGS__)
+
+#define GEM_PLUGIN_CLASS_ENTRY_TM(clsid, cls, threadModel, ...) \
+    Gem::MakePluginClassInfo<Gem::TPluginObject<cls>, threadModel>(clsid, Gem::TInterfaceList<__VA_ARGS__>{}), \
+
+// Add a class that counts itself with a Gem::PluginObjectCounter member instead of being
+// wrapped in TPluginObject (required for classes that declare GEM_EMBEDDED_AGGREGATE)
+#define GEM_PLUGIN_SELF_COUNTED_CLASS_ENTRY(clsid, cls, ...) \
+    GEM_PLUGIN_SELF_COUNTED_CLASS_ENTRY_TM(clsid, cls, Gem::DefaultThreadModel, __VA_ARGS__)
+
+#define GEM_PLUGIN_SELF_COUNTED_CLASS_ENTRY_TM(clsid, cls, threadModel, ...) \
+    Gem::MakePluginClassInfo<cls, threadModel>(clsid, Gem::TInterfaceList<__VA_ARGS__>{}), \
+
+// Complete the plugin class map
+#define END_GEM_PLUGIN_CLASS_MAP() \
+    }; \
+    *pCount = sizeof(s_Classes) / sizeof(s_Classes[0]); \
+    return s_Classes; } \
+    extern "C" GEM_PLUGIN_EXPORT unsigned long GemPluginObjectCount() { \
+        return Gem::PluginObjectCounter::Count(); \
+    } \
+    extern "C" GEM_PLUGIN_EXPORT Gem::Result GemPluginGetClassFactory(uint64_t clsid, Gem::XClassFactory **ppFactory) { \
+        size_t count = 0; \
+        const Gem::PluginClassInfo *pClasses = GemPluginClassMap(&count); \
+        return Gem::FindPluginClassFactory(pClasses, count, clsid, ppFactory); \
+    } \
+    extern "C" GEM_PLUGIN_EXPORT const Gem::PluginClassInfo *GemPluginGetClassInfo(size_t *pCount) { \
+        return GemPluginClassMap(pCount); \
+    } \
+    extern "C" GEM_PLUGIN_EXPORT void GemPluginAttach(const Gem::PluginHost *pHost) { \
+        Gem::AttachPluginModule(*pHost); \
+    } \
+    extern "C" GEM_PLUGIN_EXPORT void GemPluginDetach() { \
+        Gem::DetachPluginModule(); \
+    }
+
+// Lists classes from other modules this module needs while it initializes. Manifest scanners
+// record them, and PluginLoader::WarmUp finishes loading the modules that provide them before it
+// loads this one.
+#define GEM_PLUGIN_REQUIRED_CLASSES(...) \
+    extern "C" GEM_PLUGIN_EXPORT const uint64_t *GemPluginGetRequiredClasses(size_t *pCount) { \
+        static const uint64_t s_RequiredClasses[] = {__VA_ARGS__}; \
+        *pCount = sizeof(s_RequiredClasses) / sizeof(s_RequiredClasses[0]); \
+        return s_RequiredClasses; \
+    }
+
+// Names a function Gem::Result function(const Gem::PluginHost &host) that runs each time the
+// module is loaded, before any of its classes are created. It creates its required classes
+// through host. A failure unloads the module again and fails the load with that result.
+// The function must not create classes of its own module.
+#define GEM_PLUGIN_INITIALIZE(function) \
+    extern "C" GEM_PLUGIN_EXPORT Gem::Result GemPluginInitialize(const Gem::PluginHost *pHost) { \
+        return function(*pHost); \
+    }
+
+namespace Gem
+{
+class TrackingRegistry;
+
+//------------------------------------------------------------------------------------------------
+// One row of a plugin class map
+struct PluginClassInfo
+{
+    uint64_t ClassId;
+    XClassFactory *pFactory;
+    const uint64_t *pInterfaceIds;  // Interfaces advertised in manifests; may be empty
+    size_t InterfaceCount;
+};
+
+template<class... _XFaces>
+struct TInterfaceList
+{
+    static constexpr std::array<uint64_t, sizeof...(_XFaces)> Ids{{_XFaces::IId...}};
+};
+
+template<class _Class, class _ThreadModel, class... _XFaces>
+PluginClassInfo MakePluginClassInfo(uint64_t clsid, TInterfaceList<_XFaces...>)
+{
+    return {clsid, &TClassFactory<_Class, _ThreadModel>::Instance(), TInterfaceList<_XFaces...>::Ids.data(), sizeof...(_XFaces)};
+}
+
+inline Result FindPluginClassFactory(const PluginClassInfo *pClasses, size_t count, uint64_t clsid, _Outptr_result_nullonfailure_ XClassFactory **ppFactory)
+{
+    if (!ppFactory)
+    {
+        return Result::BadPointer;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (pClasses[i].ClassId == clsid)
+        {
+            *ppFactory = pClasses[i].pFactory;
+            (*ppFactory)->AddRef();
+            return Result::Success;
+        }
+    }
+
+    *ppFactory = nullptr;
+    return Result::NotFound;
+}
+
+//------------------------------------------------------------------------------------------------
+// The host's services, passed to a module's GEM_PLUGIN_INITIALIZE function. A module built with
+// hidden visibility has its own ClassRegistry, so its Gem::CreateInstance cannot see classes
+// the host registered; CreateInstance here looks them up in the host's.
+struct PluginHost
+{
+    Result (*pfnCreateInstance)(ClassId clsid, InterfaceId iid, void **ppObj);
+
+    // The host's object tracking registry; null unless the host defines GEM_ENABLE_OBJECT_TRACKING
+    TrackingRegistry *pTrackingRegistry;
+
+    Result CreateInstance(ClassId clsid, InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) const
+    {
+        return pfnCreateInstance(clsid, iid, ppObj);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Run in the module by its GemPluginAttach and GemPluginDetach entry points
+inline void AttachPluginModule([[maybe_unused]] const PluginHost &host)
+{
+#ifdef GEM_ENABLE_OBJECT_TRACKING
+    if (host.pTrackingRegistry)
+    {
+        TrackingRegistry::Attach(*host.pTrackingRegistry);
+    }
+#endif
+}
+
+inline void DetachPluginModule()
+{
+#ifdef GEM_ENABLE_OBJECT_TRACKING
+    TrackingRegistry::Detach();
+#endif
+}
+
+//------------------------------------------------------------------------------------------------
+// Number of objects alive in the current module. Hidden, so every module counts its own.
+class GEM_PLUGIN_LOCAL PluginObjectCounter
+{
+    static inline std::atomic<unsigned long> s_Count{0};
+
+public:
+    PluginObjectCounter() noexcept
+    {
+        s_Count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    PluginObjectCounter(const PluginObjectCounter &) noexcept :
+        PluginObjectCounter()
+    {
+    }
+
+    ~PluginObjectCounter()
+    {
+        s_Count.fetch_sub(1, std::memory_order_release);
+    }
+
+    static unsigned long Count() noexcept
+    {
+        return s_Count.load(std::memory_order_acquire);
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// _Class counted as a live object of its plugin module (see GEM_PLUGIN_CLASS_ENTRY).
+// The counter is the first base, so it is destroyed last and the count drops only once the
+// object's own destructors have finished.
+// Classes that declare GEM_EMBEDDED_AGGREGATE require TGenericImpl<_Class> as their exact outer
+// type; such classes hold a PluginObjectCounter member instead (GEM_PLUGIN_SELF_COUNTED_CLASS_ENTRY).
+template<class _Class>
+class TPluginObject : private PluginObjectCounter, public _Class
+{
+public:
+    template<typename... Arguments>
+    TPluginObject(Arguments&&... args) :
+        _Class(std::forward<Arguments>(args)...)
+    {
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Loads plugin modules on first use and unloads them when they have no live objects
+class PluginLoader
+{
+public:
+    static constexpr const char *GetClassFactoryProcName = "GemPluginGetClassFactory";
+    static constexpr const char *ObjectCountProcName = "GemPluginObjectCount";
+    static constexpr const char *GetClassInfoProcName = "GemPluginGetClassInfo";
+    static constexpr const char *GetRequiredClassesProcName = "GemPluginGetRequiredClasses";
+    static constexpr const char *InitializeProcName = "GemPluginInitialize";
+    static constexpr const char *AttachProcName = "GemPluginAttach";
+    static constexpr const char *DetachProcName = "GemPluginDetach";
+
+    using PfnGetClassFactory = Result (*)(uint64_t clsid, XClassFactory **ppFactory);
+    using PfnObjectCount = unsigned long (*)();
+    using PfnGetClassInfo = const PluginClassInfo *(*)(size_t *pCount);
+    using PfnGetRequiredClasses = const uint64_t *(*)(size_t *pCount);
+    using PfnInitialize = Result (*)(const PluginHost *pHost);
+    using PfnAttach = void (*)(const PluginHost *pHost);
+    using PfnDetach = void (*)();
+
+    // A plugin class as listed by its module's class map
+    struct ScannedClass
+    {
+        uint64_t ClassId = 0;
+        std::vector<uint64_t> InterfaceIds;
+    };
+
+private:
+    static void *OpenLibrary(const char *path) noexcept
+    {
+#ifdef _WIN32
+        return LoadLibraryA(path);
+#else
+        return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+    }
+
+    static void CloseLibrary(void *hModule) noexcept
+    {
+#ifdef _WIN32
+        FreeLibrary(static_cast<HMODULE>(hModule));
+#else
+        dlclose(hModule);
+#endif
+    }
+
+    static void *FindProc(void *hModule, const char *name) noexcept
+    {
+#ifdef _WIN32
+        return reinterpret_cast<void *>(GetProcAddress(static_cast<HMODULE>(hModule), name));
+#else
+        return dlsym(hModule, name);
+#endif
+    }
+
+    static const PluginHost &Host()
+    {
+#ifdef GEM_ENABLE_OBJECT_TRACKING
+        static const PluginHost s_Host{&Gem::CreateInstance, &TrackingRegistry::Current()};
+#else
+        static const PluginHost s_Host{&Gem::CreateInstance, nullptr};
+#endif
+        return s_Host;
+    }
+
+public:
+    //--------------------------------------------------------------------------------------------
+    // Host-side record of one module. Records are never freed: the class factories registered
+    // for the module's classes refer to them for the life of the process.
+    class Module
+    {
+        std::string m_Path;
+
+        // Shared while creating objects through the module, exclusive while loading or unloading
+        std::shared_mutex m_Mutex;
+        void *m_hModule = nullptr;
+        PfnGetClassFactory m_pfnGetClassFactory = nullptr;
+        PfnObjectCount m_pfnObjectCount = nullptr;
+        PfnDetach m_pfnDetach = nullptr;
+
+        // Creations running in module code without the lock; the module is not unloaded while
+        // any are. Incremented under the shared lock, so an unload either sees it or runs first.
+        std::atomic<unsigned long> m_UseCount{0};
+
+        // Metadata, set while registering and read by WarmUp
+        std::vector<uint64_t> m_ClassIds;
+        std::vector<uint64_t> m_RequiredClassIds;
+
+        // Requires the exclusive lock
+        Result LoadLocked() noexcept
+        {
+            if (m_hModule)
+            {
+                return Result::Success;
+            }
+
+            void *hModule = OpenLibrary(m_Path.c_str());
+            if (!hModule)
+            {
+                return Result::PluginLoadFailed;
+            }
+
+            void *pfnGetClassFactory = FindProc(hModule, GetClassFactoryProcName);
+            void *pfnObjectCount = FindProc(hModule, ObjectCountProcName);
+            if (!pfnGetClassFactory || !pfnObjectCount)
+            {
+                CloseLibrary(hModule);
+                return Result::PluginProcNotFound;
+            }
+
+            // Modules built before these entry points existed have neither
+            auto pfnDetach = reinterpret_cast<PfnDetach>(FindProc(hModule, DetachProcName));
+            if (auto pfnAttach = reinterpret_cast<PfnAttach>(FindProc(hModule, AttachProcName)))
+            {
+                pfnAttach(&Host());
+            }
+
+            if (auto pfnInitialize = reinterpret_cast<PfnInitialize>(FindProc(hModule, InitializeProcName)))
+            {
+                Result result = pfnInitialize(&Host());
+                if (Failed(result))
+                {
+                    if (pfnDetach)
+                    {
+                        pfnDetach();
+                    }
+
+                    CloseLibrary(hModule);
+                    return result;
+                }
+            }
+
+            m_pfnGetClassFactory = reinterpret_cast<PfnGetClassFactory>(pfnGetClassFactory);
+            m_pfnObjectCount = reinterpret_cast<PfnObjectCount>(pfnObjectCount);
+            m_pfnDetach = pfnDetach;
+            m_hModule = hModule;
+            return Result::Success;
+        }
+
+    public:
+        explicit Module(std::string path) :
+            m_Path(std::move(path))
+        {
+        }
+
+        const std::string &Path() const noexcept { return m_Path; }
+
+        bool IsLoaded()
+        {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+            return m_hModule != nullptr;
+        }
+
+        Result Load()
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            return LoadLocked();
+        }
+
+        // Loads the module and constructs the factories of its registered classes
+        Result LoadAndInitializeFactories()
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            Result result = LoadLocked();
+            for (uint64_t clsid : m_ClassIds)
+            {
+                if (Failed(result))
+                {
+                    break;
+                }
+
+                XClassFactory *pFactory = nullptr;
+                result = m_pfnGetClassFactory(clsid, &pFactory);
+                if (Succeeded(result))
+                {
+                    pFactory->Release();
+                }
+            }
+
+            return result;
+        }
+
+        void AddClass(ClassId clsid)
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            m_ClassIds.push_back(clsid);
+        }
+
+        bool HasClass(ClassId clsid)
+        {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+            return std::find(m_ClassIds.begin(), m_ClassIds.end(), clsid.Value) != m_ClassIds.end();
+        }
+
+        // Declares that the module needs clsid, provided by another module, to initialize
+        void AddRequiredClass(ClassId clsid)
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            if (std::find(m_RequiredClassIds.begin(), m_RequiredClassIds.end(), clsid.Value) == m_RequiredClassIds.end())
+            {
+                m_RequiredClassIds.push_back(clsid);
+            }
+        }
+
+        std::vector<uint64_t> ClassIds()
+        {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+            return m_ClassIds;
+        }
+
+        std::vector<uint64_t> RequiredClassIds()
+        {
+            std::shared_lock<std::shared_mutex> lock(m_Mutex);
+            return m_RequiredClassIds;
+        }
+
+        // Unloads the module if none of its objects are alive and no creation is running in it
+        bool UnloadIfUnused()
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            if (!m_hModule || m_UseCount.load(std::memory_order_acquire) != 0 || m_pfnObjectCount() != 0)
+            {
+                return false;
+            }
+
+            if (m_pfnDetach)
+            {
+                m_pfnDetach();
+            }
+
+            CloseLibrary(m_hModule);
+            m_hModule = nullptr;
+            m_pfnGetClassFactory = nullptr;
+            m_pfnObjectCount = nullptr;
+            m_pfnDetach = nullptr;
+            return true;
+        }
+
+        // Creates clsid through the module's factory, loading the module first if needed. The
+        // factory runs with the module pinned rather than locked, so it may itself create plugin
+        // classes or unload unused modules.
+        Result CreateInstance(ClassId clsid, InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj)
+        {
+            for (;;)
+            {
+                PfnGetClassFactory pfnGetClassFactory = nullptr;
+                {
+                    std::shared_lock<std::shared_mutex> lock(m_Mutex);
+                    if (m_hModule)
+                    {
+                        m_UseCount.fetch_add(1, std::memory_order_relaxed);
+                        pfnGetClassFactory = m_pfnGetClassFactory;
+                    }
+                }
+
+                if (pfnGetClassFactory)
+                {
+                    XClassFactory *pFactory = nullptr;
+                    Result result = pfnGetClassFactory(clsid, &pFactory);
+                    if (Succeeded(result))
+                    {
+                        result = pFactory->CreateInstance(iid, ppObj);
+                        pFactory->Release();
+                    }
+
+                    m_UseCount.fetch_sub(1, std::memory_order_release);
+                    return result;
+                }
+
+                Result result = Load();
+                if (Failed(result))
+                {
+                    return result;
+                }
+            }
+        }
+    };
+
+private:
+    //--------------------------------------------------------------------------------------------
+    // Registered in the ClassRegistry in place of a plugin class until, and after, its module
+    // is loaded. Like TClassFactory it is never destroyed, so AddRef and Release do not count.
+    class ModuleClassFactory final : public XClassFactory
+    {
+        Module *m_pModule;
+        uint64_t m_ClassId;
+
+    public:
+        ModuleClassFactory(Module *pModule, ClassId clsid) :
+            m_pModule(pModule),
+            m_ClassId(clsid)
+        {
+        }
+
+        GEMMETHOD_(unsigned long, AddRef)() final
+        {
+            return 1;
+        }
+
+        GEMMETHOD_(unsigned long, Release)() final
+        {
+            return 1;
+        }
+
+        GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+        {
+            return QueryInterfaceBorrowed(iid, ppObj);
+        }
+
+        GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+        {
+            if (!ppObj)
+            {
+                return Gem::Result::BadPointer;
+            }
+
+            if (iid == XGeneric::IId || iid == XClassFactory::IId)
+            {
+                *ppObj = static_cast<XClassFactory *>(this);
+                return Gem::Result::Success;
+            }
+
+            *ppObj = nullptr;
+            return Gem::Result::NoInterface;
+        }
+
+        GEMMETHOD(CreateInstance)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+        {
+            if (!ppObj)
+            {
+                return Gem::Result::BadPointer;
+            }
+
+            *ppObj = nullptr;
+            return m_pModule->CreateInstance(m_ClassId, iid, ppObj);
+        }
+    };
+
+    struct State
+    {
+        std::mutex Mutex;
+        std::vector<Module *> Modules;
+    };
+
+    static State &GetState()
+    {
+        // Intentionally leaked, like the modules it lists
+        static State *pState = new State;
+        return *pState;
+    }
+
+public:
+    // Returns the record for the module at path, creating it on first use. Nothing is loaded.
+    static Result GetModule(const char *path, _Outptr_result_nullonfailure_ Module **ppModule)
+    {
+        if (!path || !ppModule)
+        {
+            return Result::BadPointer;
+        }
+
+        State &state = GetState();
+        std::lock_guard<std::mutex> lock(state.Mutex);
+
+        for (Module *pExisting : state.Modules)
+        {
+            if (pExisting->Path() == path)
+            {
+                *ppModule = pExisting;
+                return Result::Success;
+            }
+        }
+
+        *ppModule = new Module(path);
+        state.Modules.push_back(*ppModule);
+        return Result::Success;
+    }
+
+    // Registers clsid with the ClassRegistry as a class provided by pModule. Succeeds without
+    // doing anything if pModule already provides clsid. Fails with InvalidArg if another module
+    // or factory provides clsid, and with Unavailable once the ClassRegistry is frozen.
+    static Result RegisterModuleClass(_In_ Module *pModule, ClassId clsid)
+    {
+        if (!pModule)
+        {
+            return Result::BadPointer;
+        }
+
+        // Serializes registrations, so the factory registered for a module's class is found here
+        // by every later registration of the same class
+        State &state = GetState();
+        std::lock_guard<std::mutex> lock(state.Mutex);
+        if (pModule->HasClass(clsid))
+        {
+            return Result::Success;
+        }
+
+        ModuleClassFactory *pFactory = new ModuleClassFactory(pModule, clsid);
+        Result result = ClassRegistry::Register(clsid, pFactory);
+        if (Failed(result))
+        {
+            delete pFactory;
+            return result;
+        }
+
+        pModule->AddClass(clsid);
+        return result;
+    }
+
+    // Records that the module at path provides the given classes and registers them with the
+    // ClassRegistry, without loading the module. Registering the same path again adds classes
+    // to the existing record; classes it already provides are skipped. Fails with Unavailable once the ClassRegistry is frozen.
+    static Result RegisterModule(const char *path, const ClassId *pClassIds, size_t classCount, _Outptr_result_nullonfailure_ Module **ppModule = nullptr)
+    {
+        if (ppModule)
+        {
+            *ppModule = nullptr;
+        }
+
+        if (classCount && !pClassIds)
+        {
+            return Result::BadPointer;
+        }
+
+        Module *pModule = nullptr;
+        Result result = GetModule(path, &pModule);
+        for (size_t i = 0; Succeeded(result) && i < classCount; ++i)
+        {
+            result = RegisterModuleClass(pModule, pClassIds[i]);
+        }
+
+        if (Succeeded(result) && ppModule)
+        {
+            *ppModule = pModule;
+        }
+
+        return result;
+    }
+
+    static Result RegisterModule(const char *path, std::initializer_list<ClassId> classIds, _Outptr_result_nullonfailure_ Module **ppModule = nullptr)
+    {
+        return RegisterModule(path, classIds.begin(), classIds.size(), ppModule);
+    }
+
+    // Opens the module at path just long enough to copy out its class map and required classes,
+    // without registering or initializing anything. Used to build plugin manifests
+    // (see GemPluginManifest.hpp).
+    static Result ScanModule(const char *path, std::vector<ScannedClass> &classes, std::vector<uint64_t> *pRequiredClassIds = nullptr)
+    {
+        classes.clear();
+        if (pRequiredClassIds)
+        {
+            pRequiredClassIds->clear();
+        }
+
+        void *hModule = OpenLibrary(path);
+        if (!hModule)
+        {
+            return Result::PluginLoadFailed;
+        }
+
+        auto pfnGetClassInfo = reinterpret_cast<PfnGetClassInfo>(FindProc(hModule, GetClassInfoProcName));
+        if (!pfnGetClassInfo)
+        {
+            CloseLibrary(hModule);
+            return Result::PluginProcNotFound;
+        }
+
+        size_t count = 0;
+        const PluginClassInfo *pClasses = pfnGetClassInfo(&count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            classes.push_back({pClasses[i].ClassId, std::vector<uint64_t>(pClasses[i].pInterfaceIds, pClasses[i].pInterfaceIds + pClasses[i].InterfaceCount)});
+        }
+
+        auto pfnGetRequiredClasses = reinterpret_cast<PfnGetRequiredClasses>(FindProc(hModule, GetRequiredClassesProcName));
+        if (pfnGetRequiredClasses && pRequiredClassIds)
+        {
+            const uint64_t *pRequired = pfnGetRequiredClasses(&count);
+            pRequiredClassIds->assign(pRequired, pRequired + count);
+        }
+
+        CloseLibrary(hModule);
+        return Result::Success;
+    }
+
+    // Unloads every loaded module with no live objects and returns how many were unloaded.
+    // A module's count drops as the last of its objects is being destroyed, so call this where
+    // no final Release can still be returning into module code, e.g. between requests.
+    static size_t UnloadUnusedModules()
+    {
+        State &state = GetState();
+        std::lock_guard<std::mutex> lock(state.Mutex);
+
+        size_t unloaded = 0;
+        for (Module *pModule : state.Modules)
+        {
+            if (pModule->UnloadIfUnused())
+            {
+                ++unloaded;
+            }
+        }
+
+        return unloaded;
+    }
+
+    // Outcome of one module in WarmUp
+    struct ModuleLoadResult
+    {
+        Module *pModule;
+        Gem::Result Result;
+    };
+
+    // Loads every registered module and constructs its class factories on up to threadCount
+    // threads (0 for one per hardware thread). Modules that provide classes another module
+    // requires are loaded first; independent modules load concurrently. A module that requires a
+    // class from a module that failed, or that is part of a requirement cycle, is not loaded and
+    // reports Unavailable. Returns Fail if any module failed; pResults receives every result.
+    static Result WarmUp(unsigned threadCount = 0, std::vector<ModuleLoadResult> *pResults = nullptr)
+    {
+        std::vector<Module *> modules;
+        {
+            State &state = GetState();
+            std::lock_guard<std::mutex> lock(state.Mutex);
+            modules = state.Modules;
+        }
+
+        size_t count = modules.size();
+        std::unordered_map<uint64_t, size_t> providers;
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (uint64_t clsid : modules[i]->ClassIds())
+            {
+                providers.emplace(clsid, i);
+            }
+        }
+
+        // Requirements on classes no registered module provides are left to the class registry
+        std::vector<std::vector<size_t>> dependents(count);
+        std::vector<size_t> pending(count, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (uint64_t clsid : modules[i]->RequiredClassIds())
+            {
+                auto provider = providers.find(clsid);
+                if (provider != providers.end() && provider->second != i)
+                {
+                    dependents[provider->second].push_back(i);
+                    ++pending[i];
+                }
+            }
+        }
+
+        std::vector<Result> results(count, Result::Unavailable);
+        std::vector<bool> blocked(count, false);
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (pending[i] == 0)
+            {
+                ready.push_back(i);
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable readyChanged;
+        size_t active = 0;
+        auto worker = [&]()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                readyChanged.wait(lock, [&] { return !ready.empty() || active == 0; });
+                if (ready.empty())
+                {
+                    // Nothing is running, so nothing more can become ready
+                    return;
+                }
+
+                size_t index = ready.back();
+                ready.pop_back();
+
+                Result result = Result::Unavailable;
+                if (!blocked[index])
+                {
+                    ++active;
+                    lock.unlock();
+                    result = modules[index]->LoadAndInitializeFactories();
+                    lock.lock();
+                    --active;
+                }
+
+                results[index] = result;
+                for (size_t dependent : dependents[index])
+                {
+                    blocked[dependent] = blocked[dependent] || Failed(result);
+                    if (--pending[dependent] == 0)
+                    {
+                        ready.push_back(dependent);
+                    }
+                }
+
+                readyChanged.notify_all();
+            }
+        };
+
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min<size_t>(threadCount, count); ++i)
+        {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        Result overall = Result::Success;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (Failed(results[i]))
+            {
+                overall = Result::Fail;
+            }
+
+            if (pResults)
+            {
+                pResults->push_back({modules[i], results[i]});
+            }
+        }
+
+        return overall;
+    }
+};
+
+}
@@ -0,0 +1,649 @@
+//================================================================================================
+// GeM (Generic Model) - Plugin manifests
+//
+// A manifest records which classes each plugin module provides, so a host can register all of
+// them at startup without loading any module:
+// - PluginManifestBuilder scans modules and writes the manifest (see the GemPluginScan tool).
+//   Modules unchanged since a previous manifest are copied from it instead of being loaded.
+// - PluginManifest maps the file read-only and uses the records in place; opening checks the
+//   header and that every offset is in bounds, and nothing is parsed or copied
+// - PluginManifest::RegisterModules hands each module's class ids to PluginLoader
+//
+// Each module record carries the file's modification time and size, checked with one stat per
+// module at startup, and a hash of its contents. A module whose time or size changed is stale;
+// RegisterModules and the builder rescan it only if its contents hash changed too.
+//================================================================================================
+
+#pragma once
+
+#include "Gem.hpp"
+#include "GemPlugin.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+// On-disk layout, in host byte order. The sections follow the header back to back:
+//   PluginManifestModule  Modules[ModuleCount]
+//   PluginManifestClass   Classes[ClassCount]
+//   uint64_t              InterfaceIds[InterfaceIdCount]
+//   uint64_t              RequiredClassIds[RequiredClassIdCount]
+//   char                  Strings[StringBytes]    NUL-terminated module paths
+// Every section size is a multiple of 8, so all records are naturally aligned in the mapping.
+struct PluginManifestHeader
+{
+    static constexpr uint32_t MagicValue = 0x4d4d4547; // "GEMM"
+    static constexpr uint32_t CurrentVersion = 2;
+
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t ModuleCount;
+    uint32_t ClassCount;
+    uint32_t InterfaceIdCount;
+    uint32_t RequiredClassIdCount;
+    uint32_t StringBytes;
+    uint32_t Reserved;
+};
+
+struct PluginManifestModule
+{
+    uint64_t ModifiedTime;      // Nanoseconds since the epoch (file_time_type ticks on Windows)
+    uint64_t FileSize;
+    uint64_t ContentHash;       // FNV-1a of the file contents
+    uint32_t PathOffset;        // Into Strings
+    uint32_t FirstClass;
+    uint32_t ClassCount;
+    uint32_t FirstRequiredClassId;
+    uint32_t RequiredClassIdCount;  // Classes from other modules needed to initialize
+    uint32_t Reserved;
+};
+
+struct PluginManifestClass
+{
+    uint64_t ClassId;
+    uint32_t FirstInterfaceId;
+    uint32_t InterfaceIdCount;
+};
+
+static_assert(sizeof(PluginManifestHeader) % 8 == 0 && sizeof(PluginManifestModule) % 8 == 0 && sizeof(PluginManifestClass) % 8 == 0,
+    "Manifest records must keep the sections 8-byte aligned");
+
+//------------------------------------------------------------------------------------------------
+// Modification time and size of a file, as recorded in PluginManifestModule
+struct PluginFileStamp
+{
+    uint64_t ModifiedTime = 0;
+    uint64_t FileSize = 0;
+
+    // One stat call; startup checks every module with it
+    static Result Get(const char *path, PluginFileStamp &stamp)
+    {
+#ifdef _WIN32
+        std::error_code error;
+        auto modifiedTime = std::filesystem::last_write_time(path, error);
+        if (error)
+        {
+            return Result::NotFound;
+        }
+
+        auto fileSize = std::filesystem::file_size(path, error);
+        if (error)
+        {
+            return Result::NotFound;
+        }
+
+        stamp.ModifiedTime = static_cast<uint64_t>(modifiedTime.time_since_epoch().count());
+        stamp.FileSize = static_cast<uint64_t>(fileSize);
+#else
+        struct stat status;
+        if (stat(path, &status) != 0)
+        {
+            return Result::NotFound;
+        }
+
+    #ifdef __APPLE__
+        const timespec &modifiedTime = status.st_mtimespec;
+    #else
+        const timespec &modifiedTime = status.st_mtim;
+    #endif
+        stamp.ModifiedTime = static_cast<uint64_t>(modifiedTime.tv_sec) * 1000000000ULL + static_cast<uint64_t>(modifiedTime.tv_nsec);
+        stamp.FileSize = static_cast<uint64_t>(status.st_size);
+#endif
+        return Result::Success;
+    }
+
+    // 64-bit FNV-1a of the file contents
+    static Result HashContents(const char *path, uint64_t &hash)
+    {
+        std::FILE *pFile = std::fopen(path, "rb");
+        if (!pFile)
+        {
+            return Result::NotFound;
+        }
+
+        hash = 0xcbf29ce484222325ULL;
+        unsigned char buffer[64 * 1024];
+        size_t bytes;
+        while ((bytes = std::fread(buffer, 1, sizeof(buffer), pFile)) != 0)
+        {
+            for (size_t i = 0; i < bytes; ++i)
+            {
+                hash ^= buffer[i];
+                hash *= 0x100000001b3ULL;
+            }
+        }
+
+        bool failed = std::ferror(pFile) != 0;
+        std::fclose(pFile);
+        return failed ? Result::Fail : Result::Success;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Read-only view of a manifest file, mapped into memory
+class PluginManifest
+{
+    const unsigned char *m_pData = nullptr;
+    size_t m_Size = 0;
+#ifdef _WIN32
+    HANDLE m_hMapping = nullptr;
+#endif
+
+    const PluginManifestHeader &Header() const noexcept
+    {
+        return *reinterpret_cast<const PluginManifestHeader *>(m_pData);
+    }
+
+    // Checks the section sizes against the file size and every offset against its section
+    bool Validate() const noexcept
+    {
+        if (m_Size < sizeof(PluginManifestHeader))
+        {
+            return false;
+        }
+
+        const PluginManifestHeader &header = Header();
+        if (header.Magic != PluginManifestHeader::MagicValue || header.Version != PluginManifestHeader::CurrentVersion)
+        {
+            return false;
+        }
+
+        uint64_t expectedSize = sizeof(PluginManifestHeader) +
+            uint64_t(header.ModuleCount) * sizeof(PluginManifestModule) +
+            uint64_t(header.ClassCount) * sizeof(PluginManifestClass) +
+            uint64_t(header.InterfaceIdCount) * sizeof(uint64_t) +
+            uint64_t(header.RequiredClassIdCount) * sizeof(uint64_t) +
+            header.StringBytes;
+        if (expectedSize != m_Size || header.StringBytes % 8 != 0 || (header.StringBytes && Strings()[header.StringBytes - 1] != '\0'))
+        {
+            return false;
+        }
+
+        for (const PluginManifestModule &module : Modules())
+        {
+            if (module.PathOffset >= header.StringBytes || uint64_t(module.FirstClass) + module.ClassCount > header.ClassCount ||
+                uint64_t(module.FirstRequiredClassId) + module.RequiredClassIdCount > header.RequiredClassIdCount)
+            {
+                return false;
+            }
+        }
+
+        for (const PluginManifestClass &manifestClass : Classes())
+        {
+            if (uint64_t(manifestClass.FirstInterfaceId) + manifestClass.InterfaceIdCount > header.InterfaceIdCount)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    const char *Strings() const noexcept
+    {
+        return reinterpret_cast<const char *>(RequiredClassIdData() + Header().RequiredClassIdCount);
+    }
+
+    const uint64_t *RequiredClassIdData() const noexcept
+    {
+        return InterfaceIdData() + Header().InterfaceIdCount;
+    }
+
+    const uint64_t *InterfaceIdData() const noexcept
+    {
+        return reinterpret_cast<const uint64_t *>(Classes().end());
+    }
+
+public:
+    // Contiguous run of manifest records
+    template<class _Record>
+    struct TRange
+    {
+        const _Record *pBegin;
+        size_t Count;
+
+        const _Record *begin() const noexcept { return pBegin; }
+        const _Record *end() const noexcept { return pBegin + Count; }
+        size_t size() const noexcept { return Count; }
+        const _Record &operator[](size_t index) const noexcept { return pBegin[index]; }
+    };
+
+    PluginManifest() = default;
+    PluginManifest(const PluginManifest &) = delete;
+    PluginManifest &operator=(const PluginManifest &) = delete;
+
+    ~PluginManifest()
+    {
+        Close();
+    }
+
+    // Maps the manifest at path. Fails with NotFound if there is no readable file, and with
+    // CorruptedData if it is not a well-formed manifest of the current version.
+    Result Open(const char *path)
+    {
+        Close();
+
+#ifdef _WIN32
+        HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return Result::NotFound;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+        {
+            CloseHandle(hFile);
+            return Result::CorruptedData;
+        }
+
+        m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (!m_hMapping)
+        {
+            return Result::Fail;
+        }
+
+        m_pData = static_cast<const unsigned char *>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_pData)
+        {
+            CloseHandle(m_hMapping);
+            m_hMapping = nullptr;
+            return Result::Fail;
+        }
+
+        m_Size = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return Result::NotFound;
+        }
+
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size == 0)
+        {
+            close(fd);
+            return Result::CorruptedData;
+        }
+
+        void *pData = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (pData == MAP_FAILED)
+        {
+            return Result::Fail;
+        }
+
+        m_pData = static_cast<const unsigned char *>(pData);
+        m_Size = static_cast<size_t>(status.st_size);
+#endif
+
+        if (!Validate())
+        {
+            Close();
+            return Result::CorruptedData;
+        }
+
+        return Result::Success;
+    }
+
+    void Close() noexcept
+    {
+        if (!m_pData)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        UnmapViewOfFile(m_pData);
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+#else
+        munmap(const_cast<unsigned char *>(m_pData), m_Size);
+#endif
+        m_pData = nullptr;
+        m_Size = 0;
+    }
+
+    bool IsOpen() const noexcept { return m_pData != nullptr; }
+
+    TRange<PluginManifestModule> Modules() const noexcept
+    {
+        if (!m_pData)
+        {
+            return {nullptr, 0};
+        }
+
+        return {reinterpret_cast<const PluginManifestModule *>(m_pData + sizeof(PluginManifestHeader)), Header().ModuleCount};
+    }
+
+    TRange<PluginManifestClass> Classes() const noexcept
+    {
+        if (!m_pData)
+        {
+            return {nullptr, 0};
+        }
+
+        return {reinterpret_cast<const PluginManifestClass *>(Modules().end()), Header().ClassCount};
+    }
+
+    TRange<PluginManifestClass> Classes(const PluginManifestModule &module) const noexcept
+    {
+        return {Classes().begin() + module.FirstClass, module.ClassCount};
+    }
+
+    TRange<uint64_t> InterfaceIds(const PluginManifestClass &manifestClass) const noexcept
+    {
+        return {InterfaceIdData() + manifestClass.FirstInterfaceId, manifestClass.InterfaceIdCount};
+    }
+
+    TRange<uint64_t> RequiredClassIds(const PluginManifestModule &module) const noexcept
+    {
+        return {RequiredClassIdData() + module.FirstRequiredClassId, module.RequiredClassIdCount};
+    }
+
+    const char *Path(const PluginManifestModule &module) const noexcept
+    {
+        return Strings() + module.PathOffset;
+    }
+
+    const PluginManifestModule *FindModule(const char *path) const noexcept
+    {
+        for (const PluginManifestModule &module : Modules())
+        {
+            if (std::strcmp(Path(module), path) == 0)
+            {
+                return &module;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // True if the module file still has the modification time and size recorded for it
+    bool IsCurrent(const PluginManifestModule &module) const
+    {
+        PluginFileStamp stamp;
+        return Succeeded(PluginFileStamp::Get(Path(module), stamp)) &&
+            stamp.ModifiedTime == module.ModifiedTime && stamp.FileSize == module.FileSize;
+    }
+
+    // Outcome of a module RegisterModules could not fully register
+    struct ModuleRegisterResult
+    {
+        std::string Path;
+        Gem::Result Result;
+    };
+
+    // Registers every module in the manifest, with its classes and required classes, with
+    // PluginLoader without loading it. A module whose time or size changed is hashed: if its
+    // contents are unchanged it is registered from the manifest, and otherwise it is scanned so
+    // its current classes are registered. Either way its path is added to pStalePaths so the
+    // caller can refresh the manifest. Classes a module already provides count as registered.
+    // A module that is missing, cannot be scanned, or provides a class registered to another
+    // module is added to pFailures and the rest are still registered; Fail is returned if there
+    // were any. Must run before ClassRegistry::Freeze.
+    Result RegisterModules(std::vector<std::string> *pStalePaths = nullptr, std::vector<ModuleRegisterResult> *pFailures = nullptr) const
+    {
+        Result overall = Result::Success;
+        std::vector<PluginLoader::ScannedClass> scanned;
+        std::vector<uint64_t> classIds;
+        std::vector<uint64_t> requiredClassIds;
+        for (const PluginManifestModule &module : Modules())
+        {
+            const char *path = Path(module);
+            Result result = Result::Success;
+            bool isUnchanged = IsCurrent(module);
+            if (!isUnchanged)
+            {
+                if (pStalePaths)
+                {
+                    pStalePaths->push_back(path);
+                }
+
+                uint64_t contentHash = 0;
+                result = PluginFileStamp::HashContents(path, contentHash);
+                isUnchanged = Succeeded(result) && contentHash == module.ContentHash;
+            }
+
+            classIds.clear();
+            if (isUnchanged)
+            {
+                for (const PluginManifestClass &manifestClass : Classes(module))
+                {
+                    classIds.push_back(manifestClass.ClassId);
+                }
+
+                auto required = RequiredClassIds(module);
+                requiredClassIds.assign(required.begin(), required.end());
+            }
+            else if (Succeeded(result))
+            {
+                result = PluginLoader::ScanModule(path, scanned, &requiredClassIds);
+                for (const PluginLoader::ScannedClass &scannedClass : scanned)
+                {
+                    classIds.push_back(scannedClass.ClassId);
+                }
+            }
+
+            PluginLoader::Module *pModule = nullptr;
+            if (Succeeded(result))
+            {
+                result = PluginLoader::GetModule(path, &pModule);
+            }
+
+            if (pModule)
+            {
+                // A class that clashes with another module's fails this module, not its other classes
+                for (uint64_t clsid : classIds)
+                {
+                    Result classResult = PluginLoader::RegisterModuleClass(pModule, clsid);
+                    if (Succeeded(result))
+                    {
+                        result = classResult;
+                    }
+                }
+
+                for (uint64_t clsid : requiredClassIds)
+                {
+                    pModule->AddRequiredClass(clsid);
+                }
+            }
+
+            if (Failed(result))
+            {
+                overall = Result::Fail;
+                if (pFailures)
+                {
+                    pFailures->push_back({path, result});
+                }
+            }
+        }
+
+        return overall;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+// Collects module records and writes them as a manifest
+class PluginManifestBuilder
+{
+public:
+    // How AddModule obtained a module's record
+    enum class Source
+    {
+        Reused,     // Time and size match the previous manifest
+        Rehashed,   // Time or size changed, but the contents hash matches
+        Scanned,    // New or changed; the module was loaded to read its class map
+    };
+
+private:
+    struct ModuleEntry
+    {
+        std::string Path;
+        PluginFileStamp Stamp;
+        uint64_t ContentHash = 0;
+        std::vector<PluginLoader::ScannedClass> Classes;
+        std::vector<uint64_t> RequiredClassIds;
+    };
+
+    std::vector<ModuleEntry> m_Modules;
+
+public:
+    // Adds the module at path. The classes are taken from pPrevious when the module is unchanged
+    // there, and otherwise read by loading the module.
+    Result AddModule(const char *path, const PluginManifest *pPrevious = nullptr, Source *pSource = nullptr)
+    {
+        ModuleEntry entry;
+        entry.Path = path;
+        Result result = PluginFileStamp::Get(path, entry.Stamp);
+        if (Failed(result))
+        {
+            return result;
+        }
+
+        const PluginManifestModule *pOld = pPrevious ? pPrevious->FindModule(path) : nullptr;
+        Source source = Source::Reused;
+        if (!pOld || pOld->ModifiedTime != entry.Stamp.ModifiedTime || pOld->FileSize != entry.Stamp.FileSize)
+        {
+            result = PluginFileStamp::HashContents(path, entry.ContentHash);
+            if (Failed(result))
+            {
+                return result;
+            }
+
+            source = pOld && pOld->ContentHash == entry.ContentHash ? Source::Rehashed : Source::Scanned;
+        }
+        else
+        {
+            entry.ContentHash = pOld->ContentHash;
+        }
+
+        if (source == Source::Scanned)
+        {
+            result = PluginLoader::ScanModule(path, entry.Classes, &entry.RequiredClassIds);
+            if (Failed(result))
+            {
+                return result;
+            }
+        }
+        else
+        {
+            for (const PluginManifestClass &manifestClass : pPrevious->Classes(*pOld))
+            {
+                auto interfaceIds = pPrevious->InterfaceIds(manifestClass);
+                entry.Classes.push_back({manifestClass.ClassId, std::vector<uint64_t>(interfaceIds.begin(), interfaceIds.end())});
+            }
+
+            auto requiredClassIds = pPrevious->RequiredClassIds(*pOld);
+            entry.RequiredClassIds.assign(requiredClassIds.begin(), requiredClassIds.end());
+        }
+
+        m_Modules.push_back(std::move(entry));
+        if (pSource)
+        {
+            *pSource = source;
+        }
+
+        return Result::Success;
+    }
+
+    // Writes the manifest to a temporary file and renames it over path, so hosts that have the
+    // previous manifest mapped keep a consistent view
+    Result Write(const char *path) const
+    {
+        PluginManifestHeader header{PluginManifestHeader::MagicValue, PluginManifestHeader::CurrentVersion, 0, 0, 0, 0, 0, 0};
+        std::vector<PluginManifestModule> modules;
+        std::vector<PluginManifestClass> classes;
+        std::vector<uint64_t> interfaceIds;
+        std::vector<uint64_t> requiredClassIds;
+        std::string strings;
+        for (const ModuleEntry &entry : m_Modules)
+        {
+            modules.push_back({entry.Stamp.ModifiedTime, entry.Stamp.FileSize, entry.ContentHash,
+                static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(classes.size()), static_cast<uint32_t>(entry.Classes.size()),
+                static_cast<uint32_t>(requiredClassIds.size()), static_cast<uint32_t>(entry.RequiredClassIds.size()), 0});
+            requiredClassIds.insert(requiredClassIds.end(), entry.RequiredClassIds.begin(), entry.RequiredClassIds.end());
+            strings.append(entry.Path).push_back('\0');
+
+            for (const PluginLoader::ScannedClass &scannedClass : entry.Classes)
+            {
+                classes.push_back({scannedClass.ClassId, static_cast<uint32_t>(interfaceIds.size()), static_cast<uint32_t>(scannedClass.InterfaceIds.size())});
+                interfaceIds.insert(interfaceIds.end(), scannedClass.InterfaceIds.begin(), scannedClass.InterfaceIds.end());
+            }
+        }
+
+        strings.resize((strings.size() + 7) & ~size_t(7), '\0');
+        header.ModuleCount = static_cast<uint32_t>(modules.size());
+        header.ClassCount = static_cast<uint32_t>(classes.size());
+        header.InterfaceIdCount = static_cast<uint32_t>(interfaceIds.size());
+        header.RequiredClassIdCount = static_cast<uint32_t>(requiredClassIds.size());
+        header.StringBytes = static_cast<uint32_t>(strings.size());
+
+        std::string tempPath = std::string(path) + ".tmp";
+        std::FILE *pFile = std::fopen(tempPath.c_str(), "wb");
+        if (!pFile)
+        {
+            return Result::Fail;
+        }
+
+        bool written =
+            std::fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+            std::fwrite(modules.data(), sizeof(PluginManifestModule), modules.size(), pFile) == modules.size() &&
+            std::fwrite(classes.data(), sizeof(PluginManifestClass), classes.size(), pFile) == classes.size() &&
+            std::fwrite(interfaceIds.data(), sizeof(uint64_t), interfaceIds.size(), pFile) == interfaceIds.size() &&
+            std::fwrite(requiredClassIds.data(), sizeof(uint64_t), requiredClassIds.size(), pFile) == requiredClassIds.size() &&
+            std::fwrite(strings.data(), 1, strings.size(), pFile) == strings.size();
+        written = std::fclose(pFile) == 0 && written;
+
+        std::error_code error;
+        if (written)
+        {
+            std::filesystem::rename(tempPath, path, error);
+        }
+
+        if (!written || error)
+        {
+            std::filesystem::remove(tempPath, error);
+            return Result::Fail;
+        }
+
+        return Result::Success;
+    }
+};
+
+}
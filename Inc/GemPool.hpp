@@ -0,0 +1,327 @@
+//================================================================================================
+// GeM (Generic Model) - Pooled object allocation
+//
+// Opt-in, per-class pooling for objects created through TGenericImpl::Create:
+// - Each class gets its own pool, segregated by allocation size
+// - Blocks are carved from large slabs and recycled through intrusive free lists
+// - Each thread keeps a small cache per size, so steady-state allocation takes no lock
+//
+// Enable pooling by adding GEM_POOLED_ALLOCATION(ClassName) to the class declaration.
+// The class-scope operator new/delete it declares are used by Create and by the
+// delete in TGenericImpl::InternalRelease. Builds without exceptions allocate through
+// the nothrow form, which returns nullptr when the pool cannot grow.
+//================================================================================================
+
+#pragma once
+
+#include "Gem.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+// Routes allocation of className (and of TGenericImpl<className>) through TObjectPool<className>
+#define GEM_POOLED_ALLOCATION(className) \
+    static void *operator new(size_t size) { \
+        static_assert(alignof(className) <= Gem::TObjectPool<className>::Granularity, "Over-aligned classes cannot be pooled"); \
+        return Gem::TObjectPool<className>::Allocate(size); \
+    } \
+    static void *operator new(size_t size, const std::nothrow_t &) noexcept { \
+        return Gem::TObjectPool<className>::TryAllocate(size); \
+    } \
+    static void operator delete(void *p, size_t size) noexcept { \
+        Gem::TObjectPool<className>::Deallocate(p, size); \
+    }
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+struct PoolStats
+{
+    size_t Live = 0;    // Blocks handed out and not yet returned
+    size_t Free = 0;    // Blocks in the shared free lists and the thread caches
+    size_t Slabs = 0;   // Slabs allocated from the global heap
+};
+
+//------------------------------------------------------------------------------------------------
+// Size-segregated block pool shared by all objects of _Class.
+// Sizes above MaxPooledSize fall through to the global operator new.
+template<class _Class>
+class TObjectPool
+{
+public:
+    static constexpr size_t Granularity = alignof(std::max_align_t);
+    static constexpr size_t MaxPooledSize = 1024;
+    static constexpr size_t SlabSize = 64 * 1024;
+
+private:
+    static constexpr size_t BucketCount = MaxPooledSize / Granularity;
+    static constexpr size_t CacheBatch = 32;
+
+    struct Block
+    {
+        Block *pNext;
+    };
+
+    struct Bucket
+    {
+        std::mutex Mutex;
+        Block *pFree = nullptr;
+        size_t FreeCount = 0;
+        size_t BlockCount = 0;
+        size_t SlabCount = 0;
+    };
+
+    struct ThreadCache;
+
+    struct Pool
+    {
+        Bucket Buckets[BucketCount];
+        std::mutex CacheMutex;
+        ThreadCache *pCaches = nullptr;
+    };
+
+    // Written only by the owning thread; the counts are atomic so GetStats can read them
+    struct CacheBucket
+    {
+        Block *pFree = nullptr;
+        std::atomic<size_t> FreeCount{0};
+    };
+
+    struct ThreadCache
+    {
+        CacheBucket Buckets[BucketCount];
+        ThreadCache *pPrev = nullptr;
+        ThreadCache *pNext = nullptr;
+
+        ThreadCache() noexcept
+        {
+            Pool &pool = GetPool();
+            std::lock_guard<std::mutex> lock(pool.CacheMutex);
+            pNext = pool.pCaches;
+            if (pNext)
+            {
+                pNext->pPrev = this;
+            }
+            pool.pCaches = this;
+            t_pCache = this;
+        }
+
+        ~ThreadCache()
+        {
+            t_pCache = nullptr;
+            t_CacheRetired = true;
+
+            Pool &pool = GetPool();
+            for (size_t index = 0; index < BucketCount; ++index)
+            {
+                CacheBucket &cached = Buckets[index];
+                ReturnBlocks(pool.Buckets[index], cached, cached.FreeCount.load(std::memory_order_relaxed));
+            }
+
+            std::lock_guard<std::mutex> lock(pool.CacheMutex);
+            (pPrev ? pPrev->pNext : pool.pCaches) = pNext;
+            if (pNext)
+            {
+                pNext->pPrev = pPrev;
+            }
+        }
+    };
+
+    static inline thread_local ThreadCache *t_pCache = nullptr;
+    static inline thread_local bool t_CacheRetired = false;
+
+    // Never destroyed: pooled objects and thread caches may outlive static destruction
+    static Pool &GetPool()
+    {
+        static Pool *pPool = new Pool;
+        return *pPool;
+    }
+
+    // Returns null once the calling thread has torn down its cache (objects released
+    // from other thread_local destructors); callers then use the shared lists directly
+    static ThreadCache *GetThreadCache() noexcept
+    {
+        if (!t_pCache && !t_CacheRetired)
+        {
+            static thread_local ThreadCache cache;
+        }
+
+        return t_pCache;
+    }
+
+    static size_t BucketIndex(size_t size) noexcept
+    {
+        return (size + Granularity - 1) / Granularity - 1;
+    }
+
+    static void ReturnBlocks(Bucket &bucket, CacheBucket &cached, size_t count) noexcept
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        Block *pFirst = cached.pFree;
+        Block *pLast = pFirst;
+        for (size_t i = 1; i < count; ++i)
+        {
+            pLast = pLast->pNext;
+        }
+        cached.pFree = pLast->pNext;
+        cached.FreeCount.store(cached.FreeCount.load(std::memory_order_relaxed) - count, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(bucket.Mutex);
+        pLast->pNext = bucket.pFree;
+        bucket.pFree = pFirst;
+        bucket.FreeCount += count;
+    }
+
+    // Moves up to CacheBatch blocks into the thread cache, carving a new slab if needed
+    static bool Refill(size_t index, Bucket &bucket, CacheBucket &cached) noexcept
+    {
+        std::lock_guard<std::mutex> lock(bucket.Mutex);
+        if (!bucket.pFree)
+        {
+            void *pSlab = ::operator new(SlabSize, std::nothrow);
+            if (!pSlab)
+            {
+                return false;
+            }
+
+            size_t blockSize = (index + 1) * Granularity;
+            size_t blockCount = SlabSize / blockSize;
+            char *pBytes = static_cast<char *>(pSlab);
+            for (size_t i = blockCount; i-- > 0;)
+            {
+                Block *pBlock = reinterpret_cast<Block *>(pBytes + i * blockSize);
+                pBlock->pNext = bucket.pFree;
+                bucket.pFree = pBlock;
+            }
+
+            bucket.FreeCount += blockCount;
+            bucket.BlockCount += blockCount;
+            ++bucket.SlabCount;
+        }
+
+        size_t moved = 0;
+        while (bucket.pFree && moved < CacheBatch)
+        {
+            Block *pBlock = bucket.pFree;
+            bucket.pFree = pBlock->pNext;
+            pBlock->pNext = cached.pFree;
+            cached.pFree = pBlock;
+            ++moved;
+        }
+
+        bucket.FreeCount -= moved;
+        cached.FreeCount.store(cached.FreeCount.load(std::memory_order_relaxed) + moved, std::memory_order_relaxed);
+        return true;
+    }
+
+public:
+    static void *TryAllocate(size_t size) noexcept
+    {
+        if (size > MaxPooledSize)
+        {
+            return ::operator new(size, std::nothrow);
+        }
+
+        size_t index = BucketIndex(size);
+        ThreadCache *pCache = GetThreadCache();
+        CacheBucket retiredCache;
+        CacheBucket &cached = pCache ? pCache->Buckets[index] : retiredCache;
+        if (!cached.pFree && !Refill(index, GetPool().Buckets[index], cached))
+        {
+            return nullptr;
+        }
+
+        Block *pBlock = cached.pFree;
+        cached.pFree = pBlock->pNext;
+        size_t count = cached.FreeCount.load(std::memory_order_relaxed) - 1;
+        cached.FreeCount.store(count, std::memory_order_relaxed);
+        if (!pCache)
+        {
+            ReturnBlocks(GetPool().Buckets[index], cached, count);
+        }
+
+        return pBlock;
+    }
+
+    static void *Allocate(size_t size)
+    {
+        void *p = TryAllocate(size);
+        if (!p)
+        {
+#if GEM_EXCEPTIONS
+            throw std::bad_alloc();
+#else
+            std::abort();
+#endif
+        }
+
+        return p;
+    }
+
+    static void Deallocate(void *p, size_t size) noexcept
+    {
+        if (!p)
+        {
+            return;
+        }
+
+        if (size > MaxPooledSize)
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        size_t index = BucketIndex(size);
+        ThreadCache *pCache = GetThreadCache();
+        CacheBucket retiredCache;
+        CacheBucket &cached = pCache ? pCache->Buckets[index] : retiredCache;
+        Block *pBlock = static_cast<Block *>(p);
+        pBlock->pNext = cached.pFree;
+        cached.pFree = pBlock;
+        size_t count = cached.FreeCount.load(std::memory_order_relaxed) + 1;
+        cached.FreeCount.store(count, std::memory_order_relaxed);
+
+        // Keep the cache bounded so blocks freed on one thread flow back to the others
+        if (!pCache || count > 2 * CacheBatch)
+        {
+            ReturnBlocks(GetPool().Buckets[index], cached, pCache ? CacheBatch : count);
+        }
+    }
+
+    // Snapshot of the pool; counts from other threads' caches may be slightly stale
+    static PoolStats GetStats()
+    {
+        Pool &pool = GetPool();
+        PoolStats stats;
+        size_t blocks = 0;
+        for (Bucket &bucket : pool.Buckets)
+        {
+            std::lock_guard<std::mutex> lock(bucket.Mutex);
+            blocks += bucket.BlockCount;
+            stats.Free += bucket.FreeCount;
+            stats.Slabs += bucket.SlabCount;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pool.CacheMutex);
+            for (ThreadCache *pCache = pool.pCaches; pCache; pCache = pCache->pNext)
+            {
+                for (CacheBucket &cached : pCache->Buckets)
+                {
+                    stats.Free += cached.FreeCount.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        stats.Live = blocks > stats.Free ? blocks - stats.Free : 0;
+        return stats;
+    }
+};
+
+}
@@ -0,0 +1,423 @@
+//================================================================================================
+// GeM (Generic Model) - Reference count tracing
+//
+// Records AddRef, Release and QueryInterface on selected objects or classes for chasing
+// reference count imbalances. Enabled by defining GEM_ENABLE_REFCOUNT_TRACING for the whole
+// program (e.g. with the CMake option of the same name); Gem.hpp then includes this header and
+// TGenericImpl reports each operation. Without the define no tracing code is compiled.
+//
+// - Nothing is recorded until objects or classes are selected with RefCountTracer
+// - Each thread appends to its own fixed-size ring buffer, so recording takes no lock
+// - RefCountTracer::Dump writes the buffers in the binary format below; Tools/GemRefTrace
+//   pairs the operations per object and reports the unmatched ones
+//
+// File layout (native byte order):
+//   RefTraceFileHeader
+//   ClassCount x { uint32_t length, char name[length] }
+//   BufferCount x { uint32_t threadIndex, uint32_t reserved, uint64_t recordCount,
+//                   RefTraceRecord records[recordCount] (oldest first) }
+//================================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifndef GEM_REFCOUNT_TRACE_CAPACITY
+    #define GEM_REFCOUNT_TRACE_CAPACITY 32768   // Records per thread; a power of two
+#endif
+
+// The traced TGenericImpl entry points are kept out of line so the return address is the call site
+#if defined(__GNUC__) || defined(__clang__)
+    #define GEM_RETURN_ADDRESS() __builtin_return_address(0)
+    #define GEM_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+    #include <intrin.h>
+    #define GEM_RETURN_ADDRESS() _ReturnAddress()
+    #define GEM_NOINLINE __declspec(noinline)
+#else
+    #define GEM_RETURN_ADDRESS() nullptr
+    #define GEM_NOINLINE
+#endif
+
+namespace Gem
+{
+//------------------------------------------------------------------------------------------------
+enum class RefTraceOp : uint8_t
+{
+    AddRef = 0,
+    Release = 1,
+    QueryInterface = 2,
+    Destroy = 3,            // Final release, however the count reached zero
+};
+
+struct RefTraceRecord
+{
+    uint64_t Timestamp;     // Steady clock, nanoseconds
+    uint64_t Object;        // Address of the TGenericImpl
+    uint64_t ReturnAddress; // Caller of the operation, when available
+    uint64_t IId;           // QueryInterface only
+    uint32_t Count;         // Count after AddRef / Release
+    uint32_t ClassIndex;    // Index into the class name table
+    uint8_t Op;             // RefTraceOp
+    uint8_t Reserved[3];
+    int32_t Result;         // QueryInterface only
+};
+
+static_assert(sizeof(RefTraceRecord) == 48, "RefTraceRecord is part of the dump format");
+
+struct RefTraceFileHeader
+{
+    static constexpr char ExpectedMagic[8] = {'G', 'E', 'M', 'T', 'R', 'A', 'C', 'E'};
+    static constexpr uint32_t CurrentVersion = 2;   // 2 added RefTraceOp::Destroy
+
+    char Magic[8];
+    uint32_t Version;
+    uint32_t ClassCount;
+    uint32_t BufferCount;
+    uint32_t Reserved;
+};
+
+//------------------------------------------------------------------------------------------------
+// Trace selection state of one TGenericImpl instantiation. Instances are never destroyed.
+class RefTraceClass
+{
+    friend class RefCountTracer;
+
+    const char *m_Name;
+    uint32_t m_Index = 0;
+    std::atomic<uint32_t> m_State{0};   // Selection generation << 1 | traced
+    RefTraceClass *m_pNext = nullptr;
+
+public:
+    explicit RefTraceClass(const char *name);
+
+    RefTraceClass(const RefTraceClass &) = delete;
+    RefTraceClass &operator=(const RefTraceClass &) = delete;
+};
+
+//------------------------------------------------------------------------------------------------
+class RefCountTracer
+{
+    friend class RefTraceClass;
+
+public:
+    static constexpr size_t Capacity = GEM_REFCOUNT_TRACE_CAPACITY;
+    static constexpr size_t MaxTracedClasses = 32;
+    static constexpr size_t MaxTracedObjects = 16;
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "GEM_REFCOUNT_TRACE_CAPACITY must be a power of two");
+
+private:
+    struct alignas(64) Buffer
+    {
+        std::atomic<uint64_t> Written{0};
+        std::atomic<bool> InUse{true};
+        uint32_t ThreadIndex = 0;   // Kept when an exited thread's buffer is reused
+        Buffer *pNext = nullptr;
+        RefTraceRecord Records[Capacity];
+    };
+
+    struct ThreadBuffer
+    {
+        Buffer *pBuffer;
+
+        ThreadBuffer() :
+            pBuffer(Claim())
+        {
+        }
+
+        ~ThreadBuffer()
+        {
+            pBuffer->InUse.store(false, std::memory_order_release);
+        }
+    };
+
+    // Non-zero while any object or class is selected; the only check made when nothing is traced
+    static inline std::atomic<uint32_t> s_Selected{0};
+    static inline std::atomic<uint32_t> s_Generation{1};
+    static inline std::atomic<bool> s_TraceAll{false};
+    static inline std::atomic<const char *> s_TracedClasses[MaxTracedClasses]{};
+    static inline std::atomic<const void *> s_TracedObjects[MaxTracedObjects]{};
+
+    static inline std::atomic<Buffer *> s_pBuffers{nullptr};
+    static inline std::atomic<uint32_t> s_NextThreadIndex{0};
+    static inline std::atomic<RefTraceClass *> s_pClasses{nullptr};
+    static inline std::atomic<uint32_t> s_ClassCount{0};
+
+    static Buffer *Claim()
+    {
+        for (Buffer *pBuffer = s_pBuffers.load(std::memory_order_acquire); pBuffer; pBuffer = pBuffer->pNext)
+        {
+            bool inUse = false;
+            if (pBuffer->InUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+            {
+                return pBuffer;
+            }
+        }
+
+        Buffer *pBuffer = new Buffer;
+        pBuffer->ThreadIndex = s_NextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        Buffer *pHead = s_pBuffers.load(std::memory_order_relaxed);
+        do
+        {
+            pBuffer->pNext = pHead;
+        } while (!s_pBuffers.compare_exchange_weak(pHead, pBuffer, std::memory_order_release, std::memory_order_relaxed));
+
+        return pBuffer;
+    }
+
+    static Buffer &ThisThread()
+    {
+        static thread_local ThreadBuffer buffer;
+        return *buffer.pBuffer;
+    }
+
+    static std::mutex &SelectionMutex()
+    {
+        static std::mutex *pMutex = new std::mutex;
+        return *pMutex;
+    }
+
+    // Called with the selection mutex held
+    static void SelectionChanged()
+    {
+        uint32_t selected = s_TraceAll.load(std::memory_order_relaxed) ? 1 : 0;
+        for (const auto &name : s_TracedClasses)
+        {
+            selected += name.load(std::memory_order_relaxed) ? 1 : 0;
+        }
+        for (const auto &object : s_TracedObjects)
+        {
+            selected += object.load(std::memory_order_relaxed) ? 1 : 0;
+        }
+
+        s_Generation.fetch_add(1, std::memory_order_release);
+        s_Selected.store(selected, std::memory_order_release);
+    }
+
+    static bool IsClassTraced(RefTraceClass &traceClass) noexcept
+    {
+        uint32_t generation = s_Generation.load(std::memory_order_acquire);
+        uint32_t state = traceClass.m_State.load(std::memory_order_relaxed);
+        if ((state >> 1) != generation)
+        {
+            bool traced = s_TraceAll.load(std::memory_order_relaxed);
+            for (const auto &name : s_TracedClasses)
+            {
+                const char *pName = name.load(std::memory_order_relaxed);
+                traced = traced || (pName && std::strcmp(pName, traceClass.m_Name) == 0);
+            }
+
+            state = (generation << 1) | (traced ? 1 : 0);
+            traceClass.m_State.store(state, std::memory_order_relaxed);
+        }
+
+        return (state & 1) != 0;
+    }
+
+    static bool IsObjectTraced(const void *pObject) noexcept
+    {
+        for (const auto &object : s_TracedObjects)
+        {
+            if (object.load(std::memory_order_relaxed) == pObject)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool Write(std::FILE *pFile, const void *pData, size_t size)
+    {
+        return std::fwrite(pData, 1, size, pFile) == size;
+    }
+
+public:
+    static bool Active() noexcept
+    {
+        return s_Selected.load(std::memory_order_relaxed) != 0;
+    }
+
+    static bool ShouldTrace(RefTraceClass &traceClass, const void *pObject) noexcept
+    {
+        return IsClassTraced(traceClass) || IsObjectTraced(pObject);
+    }
+
+    static void Record(RefTraceClass &traceClass, const void *pObject, RefTraceOp op, unsigned long count,
+        uint64_t iid, int32_t result, const void *pReturnAddress) noexcept
+    {
+        Buffer &buffer = ThisThread();
+        uint64_t written = buffer.Written.load(std::memory_order_relaxed);
+
+        RefTraceRecord &record = buffer.Records[written & (Capacity - 1)];
+        record.Timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        record.Object = reinterpret_cast<uintptr_t>(pObject);
+        record.ReturnAddress = reinterpret_cast<uintptr_t>(pReturnAddress);
+        record.IId = iid;
+        record.Count = static_cast<uint32_t>(count);
+        record.ClassIndex = traceClass.m_Index;
+        record.Op = static_cast<uint8_t>(op);
+        std::memset(record.Reserved, 0, sizeof(record.Reserved));
+        record.Result = result;
+
+        buffer.Written.store(written + 1, std::memory_order_release);
+    }
+
+    // Traces every object whose interface is named name (its XFaceName). name must stay valid
+    // while it is selected. Returns false when MaxTracedClasses names are already selected.
+    static bool TraceClass(const char *name)
+    {
+        std::lock_guard<std::mutex> lock(SelectionMutex());
+        for (auto &slot : s_TracedClasses)
+        {
+            if (!slot.load(std::memory_order_relaxed))
+            {
+                slot.store(name, std::memory_order_relaxed);
+                SelectionChanged();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void TraceAllClasses()
+    {
+        std::lock_guard<std::mutex> lock(SelectionMutex());
+        s_TraceAll.store(true, std::memory_order_relaxed);
+        SelectionChanged();
+    }
+
+    // Traces one object until its final Release. Returns false when MaxTracedObjects objects
+    // are already selected.
+    template<class _Type>
+    static bool TraceObject(_Type *pObject)
+    {
+        // The most derived object, which is what TGenericImpl records
+        const void *pIdentity = dynamic_cast<const void *>(pObject);
+
+        std::lock_guard<std::mutex> lock(SelectionMutex());
+        for (auto &slot : s_TracedObjects)
+        {
+            if (!slot.load(std::memory_order_relaxed))
+            {
+                slot.store(pIdentity, std::memory_order_relaxed);
+                SelectionChanged();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Called when a traced object is destroyed, so its address is not traced once reused
+    static void ObjectDestroyed(const void *pObject)
+    {
+        std::lock_guard<std::mutex> lock(SelectionMutex());
+        for (auto &slot : s_TracedObjects)
+        {
+            if (slot.load(std::memory_order_relaxed) == pObject)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+                SelectionChanged();
+            }
+        }
+    }
+
+    static void StopTracing()
+    {
+        std::lock_guard<std::mutex> lock(SelectionMutex());
+        s_TraceAll.store(false, std::memory_order_relaxed);
+        for (auto &slot : s_TracedClasses)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+        for (auto &slot : s_TracedObjects)
+        {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+        SelectionChanged();
+    }
+
+    // Writes all buffers, each holding its last Capacity records. Records written while the dump
+    // runs may be torn, so dump after StopTracing or once the traced objects are idle.
+    static bool Dump(std::FILE *pFile)
+    {
+        std::vector<RefTraceClass *> classes(s_ClassCount.load(std::memory_order_acquire));
+        for (RefTraceClass *pClass = s_pClasses.load(std::memory_order_acquire); pClass; pClass = pClass->m_pNext)
+        {
+            if (pClass->m_Index < classes.size())
+            {
+                classes[pClass->m_Index] = pClass;
+            }
+        }
+
+        std::vector<Buffer *> buffers;
+        for (Buffer *pBuffer = s_pBuffers.load(std::memory_order_acquire); pBuffer; pBuffer = pBuffer->pNext)
+        {
+            buffers.push_back(pBuffer);
+        }
+
+        RefTraceFileHeader header{};
+        std::memcpy(header.Magic, RefTraceFileHeader::ExpectedMagic, sizeof(header.Magic));
+        header.Version = RefTraceFileHeader::CurrentVersion;
+        header.ClassCount = static_cast<uint32_t>(classes.size());
+        header.BufferCount = static_cast<uint32_t>(buffers.size());
+        bool ok = Write(pFile, &header, sizeof(header));
+
+        for (RefTraceClass *pClass : classes)
+        {
+            // A class still being registered has no name yet
+            const char *pName = pClass ? pClass->m_Name : "";
+            uint32_t length = static_cast<uint32_t>(std::strlen(pName));
+            ok = ok && Write(pFile, &length, sizeof(length)) && Write(pFile, pName, length);
+        }
+
+        for (Buffer *pBuffer : buffers)
+        {
+            uint64_t written = pBuffer->Written.load(std::memory_order_acquire);
+            uint64_t count = written < Capacity ? written : Capacity;
+            uint32_t bufferHeader[2] = {pBuffer->ThreadIndex, 0};
+            ok = ok && Write(pFile, bufferHeader, sizeof(bufferHeader)) && Write(pFile, &count, sizeof(count));
+
+            for (uint64_t i = written - count; ok && i < written; ++i)
+            {
+                ok = Write(pFile, &pBuffer->Records[i & (Capacity - 1)], sizeof(RefTraceRecord));
+            }
+        }
+
+        return ok && std::fflush(pFile) == 0;
+    }
+
+    static bool Dump(const char *path)
+    {
+        std::FILE *pFile = std::fopen(path, "wb");
+        if (!pFile)
+        {
+            return false;
+        }
+
+        bool ok = Dump(pFile);
+        return std::fclose(pFile) == 0 && ok;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+inline RefTraceClass::RefTraceClass(const char *name) :
+    m_Name(name)
+{
+    m_Index = RefCountTracer::s_ClassCount.fetch_add(1, std::memory_order_relaxed);
+
+    RefTraceClass *pFirst = RefCountTracer::s_pClasses.load(std::memory_order_relaxed);
+    do
+    {
+        m_pNext = pFirst;
+    } while (!RefCountTracer::s_pClasses.compare_exchange_weak(pFirst, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+}
@@ -0,0 +1,411 @@
+//================================================================================================
+// GeM (Generic Model) - Live object tracking
+//
+// Opt-in leak tracking for objects created through TGenericImpl, enabled by defining
+// GEM_ENABLE_OBJECT_TRACKING for the whole program (e.g. with the CMake option of the same
+// name). Gem.hpp then includes this header and embeds a TrackedObject in every TGenericImpl;
+// without the define no tracking code is compiled.
+// - Per-class live, peak and total creation counts and bytes in use
+// - The live set, dumped on demand or at exit, with creation call stacks when
+//   GEM_OBJECT_TRACKING_STACKS is also defined and <execinfo.h> is available
+//
+// Counters and live lists are split into cache-line aligned shards chosen by the creating
+// thread, so threads creating objects of the same class do not contend.
+//
+// A plugin module built with hidden visibility has its own copy of these statics. PluginLoader
+// attaches each module to the host's TrackingRegistry while it is loaded (see GemPlugin.hpp), so
+// the host's ObjectTracker reports plugin objects too.
+//================================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#if defined(GEM_OBJECT_TRACKING_STACKS) && __has_include(<execinfo.h>)
+    #include <execinfo.h>
+    #define GEM_TRACKING_HAS_STACKS 1
+#else
+    #define GEM_TRACKING_HAS_STACKS 0
+#endif
+
+namespace Gem
+{
+class TrackedClass;
+class TrackedObject;
+
+//------------------------------------------------------------------------------------------------
+// The classes an ObjectTracker reports. Each image (the executable, or a plugin module built with
+// hidden visibility) records its classes in its current registry: its own until it is attached
+// to another image's. Detach frees an image's records before the image is unloaded.
+class TrackingRegistry
+{
+    friend class TrackedClass;
+    friend class ObjectTracker;
+
+    std::mutex m_Mutex;
+    TrackedClass *m_pFirst = nullptr;
+
+    // Created on first use, so an image attached before it creates any object never has one
+    static inline std::atomic<TrackingRegistry *> s_pLocal{nullptr};
+
+    // Null until this image is attached. Its address also tags the records this image creates.
+    static inline std::atomic<TrackingRegistry *> s_pCurrent{nullptr};
+
+public:
+    TrackingRegistry() = default;
+    TrackingRegistry(const TrackingRegistry &) = delete;
+    TrackingRegistry &operator=(const TrackingRegistry &) = delete;
+
+    // This image's own registry. Never destroyed, so objects released during static destruction
+    // can still unregister.
+    static TrackingRegistry &Local()
+    {
+        TrackingRegistry *pLocal = s_pLocal.load();
+        if (!pLocal)
+        {
+            TrackingRegistry *pNew = new TrackingRegistry;
+            if (s_pLocal.compare_exchange_strong(pLocal, pNew))
+            {
+                pLocal = pNew;
+            }
+            else
+            {
+                delete pNew;
+            }
+        }
+
+        return *pLocal;
+    }
+
+    static TrackingRegistry &Current()
+    {
+        TrackingRegistry *pCurrent = s_pCurrent.load();
+        return pCurrent ? *pCurrent : Local();
+    }
+
+    // Moves this image's records to registry and creates later ones there
+    static void Attach(TrackingRegistry &registry);
+
+    // Unlinks and frees the records this image created. Call only when none of the image's
+    // objects are alive, e.g. just before the image is unloaded.
+    static void Detach();
+};
+
+//------------------------------------------------------------------------------------------------
+struct TrackedClassStats
+{
+    const char *Name = nullptr;
+    size_t ObjectSize = 0;
+    int64_t Live = 0;
+    int64_t Peak = 0;       // Sampled every PeakSampleInterval creations per shard and on snapshot
+    uint64_t Created = 0;
+    uint64_t BytesInUse = 0;
+};
+
+//------------------------------------------------------------------------------------------------
+// Statistics and live objects of one TGenericImpl instantiation. Instances live until their image
+// detaches from its TrackingRegistry, so objects released during static destruction can still
+// unregister.
+class TrackedClass
+{
+    friend class TrackedObject;
+    friend class TrackingRegistry;
+    friend class ObjectTracker;
+
+public:
+    static constexpr unsigned ShardCount = 16;
+    static constexpr uint64_t PeakSampleInterval = 64;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<int64_t> Live{0};
+        std::atomic<uint64_t> Created{0};
+        std::mutex Mutex;
+        TrackedObject *pHead = nullptr;
+    };
+
+    const char *m_Name;
+    size_t m_ObjectSize;
+    Shard m_Shards[ShardCount];
+    std::atomic<int64_t> m_Peak{0};
+    TrackedClass *m_pNext = nullptr;
+    std::atomic<TrackedClass *> *m_pSlot;   // Cleared when the record is freed
+    const void *m_pImage;
+
+    TrackedClass(const char *name, size_t objectSize, std::atomic<TrackedClass *> &slot) :
+        m_Name(name),
+        m_ObjectSize(objectSize),
+        m_pSlot(&slot),
+        m_pImage(&TrackingRegistry::s_pCurrent)
+    {
+    }
+
+    int64_t SumLive() const noexcept
+    {
+        int64_t live = 0;
+        for (const Shard &shard : m_Shards)
+        {
+            live += shard.Live.load(std::memory_order_relaxed);
+        }
+        return live;
+    }
+
+    void UpdatePeak(int64_t live) noexcept
+    {
+        int64_t peak = m_Peak.load(std::memory_order_relaxed);
+        while (live > peak && !m_Peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static unsigned ThisThreadShard() noexcept
+    {
+        static std::atomic<unsigned> s_nextShard{0};
+        static thread_local unsigned shard = s_nextShard.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+        return shard;
+    }
+
+public:
+    // The record in slot, created in this image's current registry on first use
+    static TrackedClass &Get(std::atomic<TrackedClass *> &slot, const char *name, size_t objectSize)
+    {
+        TrackedClass *pClass = slot.load(std::memory_order_acquire);
+        while (!pClass)
+        {
+            TrackingRegistry &registry = TrackingRegistry::Current();
+            std::lock_guard<std::mutex> lock(registry.m_Mutex);
+            if (&registry != &TrackingRegistry::Current())
+            {
+                // Attached meanwhile
+                continue;
+            }
+
+            pClass = slot.load(std::memory_order_relaxed);
+            if (!pClass)
+            {
+                pClass = new TrackedClass(name, objectSize, slot);
+                pClass->m_pNext = registry.m_pFirst;
+                registry.m_pFirst = pClass;
+                slot.store(pClass, std::memory_order_release);
+            }
+        }
+
+        return *pClass;
+    }
+
+    TrackedClass(const TrackedClass &) = delete;
+    TrackedClass &operator=(const TrackedClass &) = delete;
+
+    TrackedClassStats Stats() noexcept
+    {
+        TrackedClassStats stats;
+        stats.Name = m_Name;
+        stats.ObjectSize = m_ObjectSize;
+        stats.Live = SumLive();
+        for (const Shard &shard : m_Shards)
+        {
+            stats.Created += shard.Created.load(std::memory_order_relaxed);
+        }
+
+        UpdatePeak(stats.Live);
+        stats.Peak = m_Peak.load(std::memory_order_relaxed);
+        stats.BytesInUse = stats.Live > 0 ? static_cast<uint64_t>(stats.Live) * m_ObjectSize : 0;
+        return stats;
+    }
+};
+
+//------------------------------------------------------------------------------------------------
+inline void TrackingRegistry::Attach(TrackingRegistry &registry)
+{
+    // Sequentially consistent with the loads in Local and Current, so a record created in the
+    // local registry concurrently is either seen here or created in registry
+    s_pCurrent.store(&registry);
+    TrackingRegistry *pLocal = s_pLocal.load();
+    if (!pLocal || pLocal == &registry)
+    {
+        return;
+    }
+
+    std::scoped_lock lock(pLocal->m_Mutex, registry.m_Mutex);
+    while (TrackedClass *pClass = pLocal->m_pFirst)
+    {
+        pLocal->m_pFirst = pClass->m_pNext;
+        pClass->m_pNext = registry.m_pFirst;
+        registry.m_pFirst = pClass;
+    }
+}
+
+inline void TrackingRegistry::Detach()
+{
+    TrackingRegistry &registry = Current();
+    std::lock_guard<std::mutex> lock(registry.m_Mutex);
+    TrackedClass **ppClass = &registry.m_pFirst;
+    while (TrackedClass *pClass = *ppClass)
+    {
+        if (pClass->m_pImage == &s_pCurrent)
+        {
+            *ppClass = pClass->m_pNext;
+            pClass->m_pSlot->store(nullptr, std::memory_order_relaxed);
+            delete pClass;
+        }
+        else
+        {
+            ppClass = &pClass->m_pNext;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+// Embedded in each tracked object: links the object into its class's live list for its lifetime
+class TrackedObject
+{
+    friend class ObjectTracker;
+
+public:
+    static constexpr int MaxFrames = 16;
+
+private:
+    TrackedClass *m_pClass;
+    const void *m_pObject;
+    TrackedObject *m_pPrev = nullptr;
+    TrackedObject *m_pNext = nullptr;
+    unsigned m_Shard;
+#if GEM_TRACKING_HAS_STACKS
+    void *m_Frames[MaxFrames];
+    int m_FrameCount;
+#endif
+
+public:
+    TrackedObject(TrackedClass &trackedClass, const void *pObject) noexcept :
+        m_pClass(&trackedClass),
+        m_pObject(pObject),
+        m_Shard(TrackedClass::ThisThreadShard())
+    {
+#if GEM_TRACKING_HAS_STACKS
+        m_FrameCount = backtrace(m_Frames, MaxFrames);
+#endif
+
+        TrackedClass::Shard &shard = m_pClass->m_Shards[m_Shard];
+        {
+            std::lock_guard<std::mutex> lock(shard.Mutex);
+            m_pNext = shard.pHead;
+            if (m_pNext)
+            {
+                m_pNext->m_pPrev = this;
+            }
+            shard.pHead = this;
+        }
+
+        shard.Live.fetch_add(1, std::memory_order_relaxed);
+        if (shard.Created.fetch_add(1, std::memory_order_relaxed) % TrackedClass::PeakSampleInterval == 0)
+        {
+            m_pClass->UpdatePeak(m_pClass->SumLive());
+        }
+    }
+
+    ~TrackedObject()
+    {
+        TrackedClass::Shard &shard = m_pClass->m_Shards[m_Shard];
+        {
+            std::lock_guard<std::mutex> lock(shard.Mutex);
+            if (m_pPrev)
+            {
+                m_pPrev->m_pNext = m_pNext;
+            }
+            else
+            {
+                shard.pHead = m_pNext;
+            }
+
+            if (m_pNext)
+            {
+                m_pNext->m_pPrev = m_pPrev;
+            }
+        }
+
+        shard.Live.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    TrackedObject(const TrackedObject &) = delete;
+    TrackedObject &operator=(const TrackedObject &) = delete;
+};
+
+//------------------------------------------------------------------------------------------------
+class ObjectTracker
+{
+    static void DumpLiveAtExit()
+    {
+        if (DumpLiveObjects(stderr) != 0)
+        {
+            DumpStats(stderr);
+        }
+    }
+
+public:
+    // Statistics of every class that has created at least one object. The names of a plugin
+    // module's classes are valid until the module is unloaded.
+    static std::vector<TrackedClassStats> Snapshot()
+    {
+        std::vector<TrackedClassStats> stats;
+        TrackingRegistry &registry = TrackingRegistry::Current();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+        for (TrackedClass *pClass = registry.m_pFirst; pClass; pClass = pClass->m_pNext)
+        {
+            stats.push_back(pClass->Stats());
+        }
+        return stats;
+    }
+
+    static void DumpStats(std::FILE *pFile)
+    {
+        std::fprintf(pFile, "%-40s %12s %12s %14s %14s\n", "Class", "Live", "Peak", "Created", "Bytes");
+        for (const TrackedClassStats &stats : Snapshot())
+        {
+            std::fprintf(pFile, "%-40s %12lld %12lld %14llu %14llu\n", stats.Name,
+                static_cast<long long>(stats.Live), static_cast<long long>(stats.Peak),
+                static_cast<unsigned long long>(stats.Created), static_cast<unsigned long long>(stats.BytesInUse));
+        }
+    }
+
+    // Writes one line per live object, followed by its creation stack when captured.
+    // Returns the number of live objects.
+    static size_t DumpLiveObjects(std::FILE *pFile)
+    {
+        size_t count = 0;
+        TrackingRegistry &registry = TrackingRegistry::Current();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+        for (TrackedClass *pClass = registry.m_pFirst; pClass; pClass = pClass->m_pNext)
+        {
+            for (TrackedClass::Shard &shard : pClass->m_Shards)
+            {
+                std::lock_guard<std::mutex> lock(shard.Mutex);
+                for (TrackedObject *pObject = shard.pHead; pObject; pObject = pObject->m_pNext)
+                {
+                    std::fprintf(pFile, "Live %s at %p (%zu bytes)\n", pClass->m_Name, pObject->m_pObject, pClass->m_ObjectSize);
+#if GEM_TRACKING_HAS_STACKS
+                    std::fflush(pFile);
+                    backtrace_symbols_fd(pObject->m_Frames, pObject->m_FrameCount, fileno(pFile));
+#endif
+                    ++count;
+                }
+            }
+        }
+
+        return count;
+    }
+
+    // Dumps the live set and class statistics to stderr at exit if any tracked object is still
+    // alive. Objects with static storage duration may still be alive at that point.
+    static void DumpLeaksAtExit()
+    {
+        std::atexit(&DumpLiveAtExit);
+    }
+};
+
+}
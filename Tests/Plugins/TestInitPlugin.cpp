@@ -0,0 +1,65 @@
+//================================================================================================
+// Plugin module for the initialization order tests
+//
+// Built once per index; GEM_TEST_INIT_PLUGIN_INDEX selects the class id the module provides.
+// When loaded, the module appends its index to the host's XTestInitLog and then, for index > 0,
+// creates its required class through the host.
+//================================================================================================
+
+#include "TestPlugin.hpp"
+
+#include <GemPlugin.hpp>
+
+namespace GemTest
+{
+class CTestInitPluginService : public Gem::TGeneric<XTestPluginService>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XTestPluginService)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(int) Answer() override { return GEM_TEST_INIT_PLUGIN_INDEX; }
+
+    GEMMETHODIMP_(void) SetCreateHook(void (*)()) override {}
+};
+
+Gem::Result InitializePlugin(const Gem::PluginHost &host)
+{
+    XTestInitLog *pLog = nullptr;
+    Gem::Result result = host.CreateInstance(TestInitLogClassId, GEM_IID_PPV_ARGS(&pLog));
+    if (Gem::Failed(result))
+    {
+        return result;
+    }
+
+    pLog->Append(GEM_TEST_INIT_PLUGIN_INDEX);
+    pLog->Release();
+
+#if GEM_TEST_INIT_PLUGIN_INDEX > 0
+    XTestPluginService *pRequired = nullptr;
+    result = host.CreateInstance(TestInitPluginRequiredClassId(GEM_TEST_INIT_PLUGIN_INDEX), GEM_IID_PPV_ARGS(&pRequired));
+    if (Gem::Failed(result))
+    {
+        return result;
+    }
+
+    pRequired->Release();
+#endif
+
+    return Gem::Result::Success;
+}
+
+}
+
+GEM_PLUGIN_INITIALIZE(GemTest::InitializePlugin)
+
+#if GEM_TEST_INIT_PLUGIN_INDEX > 0
+GEM_PLUGIN_REQUIRED_CLASSES(GemTest::TestInitPluginRequiredClassId(GEM_TEST_INIT_PLUGIN_INDEX))
+#endif
+
+BEGIN_GEM_PLUGIN_CLASS_MAP()
+    GEM_PLUGIN_CLASS_ENTRY(GemTest::TestInitPluginClassId(GEM_TEST_INIT_PLUGIN_INDEX), GemTest::CTestInitPluginService, GemTest::XTestPluginService)
+END_GEM_PLUGIN_CLASS_MAP()
@@ -0,0 +1,38 @@
+//================================================================================================
+// Plugin module for the plugin loader tests, providing TestPluginClassId and TestPluginCopyClassId
+//================================================================================================
+
+#include "TestPlugin.hpp"
+
+#include <GemPlugin.hpp>
+
+namespace GemTest
+{
+class CTestPluginService : public Gem::TGeneric<XTestPluginService>
+{
+    static inline void (*s_pfnCreateHook)() = nullptr;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XTestPluginService)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize()
+    {
+        if (s_pfnCreateHook)
+        {
+            s_pfnCreateHook();
+        }
+    }
+
+    GEMMETHODIMP_(int) Answer() override { return 42; }
+
+    GEMMETHODIMP_(void) SetCreateHook(void (*pfnHook)()) override { s_pfnCreateHook = pfnHook; }
+};
+
+}
+
+BEGIN_GEM_PLUGIN_CLASS_MAP()
+    GEM_PLUGIN_CLASS_ENTRY(GemTest::TestPluginClassId, GemTest::CTestPluginService, GemTest::XTestPluginService)
+    GEM_PLUGIN_CLASS_ENTRY(GemTest::TestPluginCopyClassId, GemTest::CTestPluginService, GemTest::XTestPluginService)
+END_GEM_PLUGIN_CLASS_MAP()
@@ -0,0 +1,55 @@
+//================================================================================================
+// Interfaces and class ids shared by the test plugins and TestPlugins.cpp
+//
+// TestInitPlugin.cpp is built once per index; module i provides TestInitPluginClassId(i) and, for
+// i > 0, creates TestInitPluginRequiredClassId(i) while it initializes.
+//================================================================================================
+
+#pragma once
+
+#include <Gem.hpp>
+
+#include <cstdint>
+
+namespace GemTest
+{
+struct XTestPluginService : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XTestPluginService, 0x5E21C8B7A04D396F);
+
+    GEMMETHOD_(int, Answer)() = 0;
+
+    // Sets a host function every later creation of the class calls from Initialize
+    GEMMETHOD_(void, SetCreateHook)(void (*pfnHook)()) = 0;
+};
+
+// The plugin provides the same class under both ids, so copies of it can be registered under
+// the second id without clashing with the original
+constexpr uint64_t TestPluginClassId = Gem::HashInterfaceName("GemTest::CTestPluginService");
+constexpr uint64_t TestPluginCopyClassId = TestPluginClassId + 1;
+
+// Implemented by the host; each initialization plugin appends its index when it initializes
+struct XTestInitLog : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XTestInitLog, 0x7D04E9A3C2B6518F);
+
+    GEMMETHOD_(void, Append)(int moduleIndex) = 0;
+};
+
+constexpr uint64_t TestInitLogClassId = Gem::HashInterfaceName("GemTest::CTestInitLog");
+
+// Provided by no module
+constexpr uint64_t TestMissingClassId = Gem::HashInterfaceName("GemTest::CTestMissing");
+
+constexpr uint64_t TestInitPluginClassId(unsigned index)
+{
+    return Gem::HashInterfaceName("GemTest::CTestInitPluginService") + index;
+}
+
+// Module 1 requires module 0's class; module 2 requires a class no module provides
+constexpr uint64_t TestInitPluginRequiredClassId(unsigned index)
+{
+    return index == 1 ? TestInitPluginClassId(0) : TestMissingClassId;
+}
+
+}
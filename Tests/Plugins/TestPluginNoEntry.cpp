@@ -0,0 +1,10 @@
+//================================================================================================
+// A shared library that loads but exports none of the plugin entry points
+//================================================================================================
+
+#include <GemPlugin.hpp>
+
+extern "C" GEM_PLUGIN_EXPORT int GemTestNotAPlugin()
+{
+    return 0;
+}
@@ -0,0 +1,283 @@
+//================================================================================================
+// TAtomicGemPtr tests
+//
+// - Readers never see the published value go back in time, even while writers race to
+//   complete their reads
+// - A writer that saw one read announced does not complete the same thread's next read
+// - Every replaced object is released
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemAtomicPtr.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace GemTest
+{
+struct XSequence : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XSequence, 0x5C07E1A94B3D2F86);
+
+    GEMMETHOD_(uint64_t, Value)() = 0;
+};
+
+std::atomic<long> s_LiveSequences{0};
+
+class CSequence : public Gem::TGeneric<XSequence>
+{
+    uint64_t m_Value;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XSequence)
+    END_GEM_INTERFACE_MAP()
+
+    explicit CSequence(uint64_t value) :
+        m_Value(value)
+    {
+        s_LiveSequences.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~CSequence()
+    {
+        s_LiveSequences.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(uint64_t) Value() override { return m_Value; }
+};
+
+Gem::TGemPtr<XSequence> MakeSequence(uint64_t value)
+{
+    Gem::TGemPtr<CSequence> pObj;
+    Gem::TGenericImpl<CSequence>::Create(&pObj, value);
+    return Gem::TGemPtr<XSequence>(pObj.Get());
+}
+
+//------------------------------------------------------------------------------------------------
+// Two writers publish strictly increasing values with CompareExchange, so the published sequence
+// is monotonic; their completions of announced reads overlap. Each reader checks that the values
+// it loads never decrease.
+GEM_TEST(AtomicPtr_ReadersNeverGoBack)
+{
+    constexpr unsigned WriterCount = 2;
+    constexpr unsigned ReaderCount = 4;
+    constexpr auto Duration = std::chrono::milliseconds(300);
+
+    {
+        Gem::TAtomicGemPtr<XSequence> pPublished(MakeSequence(0).Get());
+        std::atomic<bool> stop{false};
+        std::atomic<unsigned> regressions{0};
+        std::atomic<uint64_t> loads{0};
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < WriterCount; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    Gem::TGemPtr<XSequence> pExpected = pPublished.Load();
+                    Gem::TGemPtr<XSequence> pNext = MakeSequence(pExpected->Value() + 1);
+                    while (!pPublished.CompareExchange(pExpected, pNext.Get()))
+                    {
+                        pNext = MakeSequence(pExpected->Value() + 1);
+                    }
+                }
+            });
+        }
+
+        for (unsigned i = 0; i < ReaderCount; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                uint64_t last = 0;
+                uint64_t count = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    uint64_t value = pPublished.Load()->Value();
+                    if (value < last)
+                    {
+                        regressions.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    last = value;
+                    ++count;
+                }
+
+                loads.fetch_add(count, std::memory_order_relaxed);
+            });
+        }
+
+        std::this_thread::sleep_for(Duration);
+        stop.store(true, std::memory_order_relaxed);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        GEM_CHECK(regressions.load() == 0);
+        GEM_CHECK(loads.load() > 0);
+        GEM_CHECK(pPublished.Load()->Value() > 0);
+    }
+
+    GEM_CHECK(s_LiveSequences.load() == 0);
+}
+
+//------------------------------------------------------------------------------------------------
+// XSequence with its own reference count, whose AddRef stalls on threads that set
+// t_SlowAddRef. A writer completing an announced read takes its reference inside that gap.
+thread_local bool t_SlowAddRef = false;
+
+class CSlowSequence final : public XSequence
+{
+    std::atomic<unsigned long> m_RefCount{1};
+    uint64_t m_Value;
+
+public:
+    explicit CSlowSequence(uint64_t value) :
+        m_Value(value)
+    {
+        s_LiveSequences.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~CSlowSequence()
+    {
+        s_LiveSequences.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    GEMMETHODIMP_(unsigned long) AddRef() override
+    {
+        if (t_SlowAddRef)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+
+        return m_RefCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    GEMMETHODIMP_(unsigned long) Release() override
+    {
+        unsigned long count = m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        if (count == 0)
+        {
+            delete this;
+        }
+
+        return count;
+    }
+
+    GEMMETHODIMP QueryInterface(Gem::InterfaceId iid, void **ppObj) override
+    {
+        Gem::Result result = QueryInterfaceBorrowed(iid, ppObj);
+        if (Gem::Succeeded(result))
+        {
+            AddRef();
+        }
+
+        return result;
+    }
+
+    GEMMETHODIMP QueryInterfaceBorrowed(Gem::InterfaceId iid, void **ppObj) override
+    {
+        if (iid == XSequence::IId || iid == Gem::XGeneric::IId)
+        {
+            *ppObj = static_cast<XSequence *>(this);
+            return Gem::Result::Success;
+        }
+
+        *ppObj = nullptr;
+        return Gem::Result::NoInterface;
+    }
+
+    GEMMETHODIMP_(uint64_t) Value() override { return m_Value; }
+};
+
+Gem::TGemPtr<XSequence> MakeSlowSequence(uint64_t value)
+{
+    Gem::TGemPtr<XSequence> pObj;
+    pObj.Attach(new CSlowSequence(value));
+    return pObj;
+}
+
+//------------------------------------------------------------------------------------------------
+// Readers load back to back while writers stall inside the completion of announced reads, so a
+// writer that saw one read announced often finds a later read announced on the same slot. Each
+// value must be no older than the previous one, nor than a value published before its load.
+GEM_TEST(AtomicPtr_BackToBackLoadsNeverGoBack)
+{
+    constexpr unsigned WriterCount = 3;
+    constexpr unsigned ReaderCount = 3;
+    constexpr auto Duration = std::chrono::milliseconds(300);
+
+    {
+        Gem::TAtomicGemPtr<XSequence> pPublished(MakeSlowSequence(0).Get());
+        std::atomic<bool> stop{false};
+        std::atomic<unsigned> regressions{0};
+
+        // Raised by writers once their value is published; loads that start later must not
+        // return anything older
+        std::atomic<uint64_t> publishedFloor{0};
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < WriterCount; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                t_SlowAddRef = true;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    Gem::TGemPtr<XSequence> pExpected = pPublished.Load();
+                    Gem::TGemPtr<XSequence> pNext = MakeSlowSequence(pExpected->Value() + 1);
+                    while (!pPublished.CompareExchange(pExpected, pNext.Get()))
+                    {
+                        pNext = MakeSlowSequence(pExpected->Value() + 1);
+                    }
+
+                    uint64_t floor = publishedFloor.load(std::memory_order_relaxed);
+                    while (floor < pNext->Value() && !publishedFloor.compare_exchange_weak(floor, pNext->Value(), std::memory_order_release))
+                    {
+                    }
+                }
+            });
+        }
+
+        for (unsigned i = 0; i < ReaderCount; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                uint64_t last = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    uint64_t floor = publishedFloor.load(std::memory_order_acquire);
+                    uint64_t value = pPublished.Load()->Value();
+                    if (value < last || value < floor)
+                    {
+                        regressions.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    last = value;
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(Duration);
+        stop.store(true, std::memory_order_relaxed);
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        GEM_CHECK(regressions.load() == 0);
+    }
+
+    GEM_CHECK(s_LiveSequences.load() == 0);
+}
+
+}
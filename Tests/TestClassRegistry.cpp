@@ -0,0 +1,226 @@
+//================================================================================================
+// Class registry tests
+//
+// Built as its own executable, GemTestsClassRegistry: the registry is process global and can be
+// frozen only once, so the tests run in order and share one registry.
+// - Before Freeze, lookups take the mutex path; registering an id again succeeds for the same
+//   factory and fails for another
+// - Lookups racing Freeze find every registered class
+// - After Freeze, the perfect hash finds every class, including ids that share a bucket, and
+//   returns null for unregistered ids
+// - Register after Freeze fails with Unavailable
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemClassFactory.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace GemTest
+{
+struct XRegistryTest : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XRegistryTest, 0x58D2A7E3140F9BC6);
+};
+
+class CRegistryTest : public Gem::TGeneric<XRegistryTest>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XRegistryTest)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+constexpr uint64_t RegistryTestClassId = Gem::HashInterfaceName("GemTest::CRegistryTest");
+
+// Factory that only identifies itself; the registry never creates through it in these tests
+class CStubFactory final : public Gem::XClassFactory
+{
+public:
+    GEMMETHOD_(unsigned long, AddRef)() final
+    {
+        return 1;
+    }
+
+    GEMMETHOD_(unsigned long, Release)() final
+    {
+        return 1;
+    }
+
+    GEMMETHOD(QueryInterface)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        return QueryInterfaceBorrowed(iid, ppObj);
+    }
+
+    GEMMETHOD(QueryInterfaceBorrowed)(Gem::InterfaceId iid, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (!ppObj)
+        {
+            return Gem::Result::BadPointer;
+        }
+
+        if (iid == Gem::XGeneric::IId || iid == Gem::XClassFactory::IId)
+        {
+            *ppObj = static_cast<Gem::XClassFactory *>(this);
+            return Gem::Result::Success;
+        }
+
+        *ppObj = nullptr;
+        return Gem::Result::NoInterface;
+    }
+
+    GEMMETHOD(CreateInstance)(Gem::InterfaceId, _Outptr_result_nullonfailure_ void **ppObj) final
+    {
+        if (ppObj)
+        {
+            *ppObj = nullptr;
+        }
+
+        return Gem::Result::NotImplemented;
+    }
+};
+
+// Enough ids that many buckets hold several, including ids that differ only in their high or
+// low bits
+constexpr size_t StubCount = 3000;
+
+uint64_t StubClassId(size_t index)
+{
+    switch (index % 3)
+    {
+    case 0:
+        return 0x1000 + index;
+    case 1:
+        return (uint64_t(index) << 48) | 0x1;
+    default:
+        return Gem::HashInterfaceName("GemTest::Stub") ^ (uint64_t(index) * 0x9E3779B97F4A7C15ULL);
+    }
+}
+
+// Never destroyed; the registry holds the factories for the life of the process
+std::vector<CStubFactory> &StubFactories()
+{
+    static std::vector<CStubFactory> *pFactories = new std::vector<CStubFactory>(StubCount);
+    return *pFactories;
+}
+
+bool FindsEveryStub()
+{
+    std::vector<CStubFactory> &factories = StubFactories();
+    for (size_t i = 0; i < StubCount; ++i)
+    {
+        if (Gem::ClassRegistry::Find(StubClassId(i)) != &factories[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Ids no test registers
+uint64_t UnregisteredClassId(size_t index)
+{
+    return Gem::HashInterfaceName("GemTest::Unregistered") + index * 7919;
+}
+
+GEM_TEST(Registry_RegisterAndFindBeforeFreeze)
+{
+    GEM_CHECK(!Gem::ClassRegistry::IsFrozen());
+
+    std::vector<CStubFactory> &factories = StubFactories();
+    for (size_t i = 0; i < StubCount; ++i)
+    {
+        GEM_CHECK(Gem::ClassRegistry::Register(StubClassId(i), &factories[i]) == Gem::Result::Success);
+    }
+
+    GEM_CHECK(FindsEveryStub());
+    GEM_CHECK(Gem::ClassRegistry::Find(UnregisteredClassId(0)) == nullptr);
+
+    // The same factory again is accepted; another factory for a taken id is not
+    GEM_CHECK(Gem::ClassRegistry::Register(StubClassId(0), &factories[0]) == Gem::Result::Success);
+    GEM_CHECK(Gem::ClassRegistry::Register(StubClassId(0), &factories[1]) == Gem::Result::InvalidArg);
+    GEM_CHECK(Gem::ClassRegistry::Find(StubClassId(0)) == &factories[0]);
+
+    GEM_CHECK(Gem::ClassRegistry::Register(RegistryTestClassId, &Gem::TClassFactory<CRegistryTest>::Instance()) == Gem::Result::Success);
+    GEM_CHECK(Gem::ClassRegistry::Register(RegistryTestClassId, nullptr) == Gem::Result::BadPointer);
+}
+
+GEM_TEST(Registry_FindRacesFreeze)
+{
+    constexpr int ThreadCount = 3;
+
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < ThreadCount; ++t)
+    {
+        threads.emplace_back([&]()
+        {
+            while (!start.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            // Lookups before, during and after the switch to the frozen table
+            do
+            {
+                GEM_CHECK(FindsEveryStub());
+            } while (!Gem::ClassRegistry::IsFrozen());
+
+            GEM_CHECK(FindsEveryStub());
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    Gem::ClassRegistry::Freeze();
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    GEM_CHECK(Gem::ClassRegistry::IsFrozen());
+
+    // Later calls do nothing
+    Gem::ClassRegistry::Freeze();
+    GEM_CHECK(FindsEveryStub());
+}
+
+GEM_TEST(Registry_FindAfterFreeze)
+{
+    GEM_CHECK(Gem::ClassRegistry::IsFrozen());
+    GEM_CHECK(FindsEveryStub());
+
+    // Unregistered ids land on empty slots or on other classes' slots, and are never matched
+    size_t found = 0;
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        found += Gem::ClassRegistry::Find(UnregisteredClassId(i)) != nullptr;
+    }
+
+    GEM_CHECK(found == 0);
+    GEM_CHECK(Gem::ClassRegistry::Find(uint64_t(0)) == nullptr);
+
+    Gem::TGemPtr<XRegistryTest> pObject;
+    GEM_CHECK(Gem::Succeeded(Gem::CreateInstance(RegistryTestClassId, GEM_IID_PPV_ARGS(&pObject))));
+    GEM_CHECK(pObject.Get() != nullptr);
+    GEM_CHECK(Gem::CreateInstance(UnregisteredClassId(0), GEM_IID_PPV_ARGS(&pObject)) == Gem::Result::NotFound);
+}
+
+GEM_TEST(Registry_RegisterAfterFreezeIsUnavailable)
+{
+    std::vector<CStubFactory> &factories = StubFactories();
+    GEM_CHECK(Gem::ClassRegistry::Register(UnregisteredClassId(0), &factories[0]) == Gem::Result::Unavailable);
+    GEM_CHECK(Gem::ClassRegistry::Find(UnregisteredClassId(0)) == nullptr);
+
+    // Even for a class that is already registered
+    GEM_CHECK(Gem::ClassRegistry::Register(StubClassId(0), &factories[0]) == Gem::Result::Unavailable);
+    GEM_CHECK(Gem::ClassRegistry::Find(StubClassId(0)) == &factories[0]);
+}
+}
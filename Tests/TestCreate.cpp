@@ -0,0 +1,296 @@
+//================================================================================================
+// Object creation tests
+//
+// Also built without exceptions as GemTestsNoExceptions.
+// - A failing Result-returning Initialize destroys the object and is returned from Create
+//
+// CreateWith:
+// - The object is allocated from the given memory resource, and its final Release returns the
+//   same block to it
+// - A constructor that throws, an Initialize that fails and an exhausted resource each report
+//   their result and leave nothing allocated from the resource
+//
+// Create and CreateWith forward their arguments to the constructor unchanged: move-only values
+// are moved, lvalue references bind to the caller's objects and nothing is copied
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace GemTest
+{
+// Counts the blocks allocated from it; optionally fails every allocation (only with exception
+// support, since a memory_resource can only fail by throwing). A deallocation that
+// does not match the last allocation's block, size and alignment counts as mismatched.
+class CountingResource : public std::pmr::memory_resource
+{
+    std::pmr::memory_resource *m_pUpstream = std::pmr::new_delete_resource();
+    void *m_pLastBlock = nullptr;
+    size_t m_LastBytes = 0;
+    size_t m_LastAlignment = 0;
+
+public:
+    size_t Allocations = 0;
+    size_t Deallocations = 0;
+    size_t BytesInUse = 0;
+    size_t MismatchedFrees = 0;
+    bool Exhausted = false;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+#if GEM_EXCEPTIONS
+        if (Exhausted)
+        {
+            throw std::bad_alloc();
+        }
+#endif
+
+        void *p = m_pUpstream->allocate(bytes, alignment);
+        m_pLastBlock = p;
+        m_LastBytes = bytes;
+        m_LastAlignment = alignment;
+        ++Allocations;
+        BytesInUse += bytes;
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        if (p != m_pLastBlock || bytes != m_LastBytes || alignment != m_LastAlignment)
+        {
+            ++MismatchedFrees;
+        }
+
+        ++Deallocations;
+        BytesInUse -= bytes;
+        m_pUpstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+struct XResourceObject : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XResourceObject, 0x0B7C3E95A1D4862F);
+};
+
+class CResourceObject : public Gem::TGeneric<XResourceObject>
+{
+    Gem::Result m_InitializeResult;
+    int *m_pDestroyed;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XResourceObject)
+    END_GEM_INTERFACE_MAP()
+
+    CResourceObject(int *pDestroyed, Gem::Result constructResult = Gem::Result::Success, Gem::Result initializeResult = Gem::Result::Success) :
+        m_InitializeResult(initializeResult),
+        m_pDestroyed(pDestroyed)
+    {
+        Gem::ThrowGemError(constructResult);
+    }
+
+    ~CResourceObject()
+    {
+        ++*m_pDestroyed;
+    }
+
+    Gem::Result Initialize()
+    {
+        return m_InitializeResult;
+    }
+};
+
+using CResourceObjectImpl = Gem::TGenericImpl<CResourceObject>;
+
+GEM_TEST(Create_InitializeFailureDestroysObject)
+{
+    int destroyed = 0;
+    CResourceObject *pObject = nullptr;
+    GEM_CHECK(CResourceObjectImpl::Create(&pObject, &destroyed, Gem::Result::Success, Gem::Result::Unavailable) == Gem::Result::Unavailable);
+    GEM_CHECK(pObject == nullptr);
+    GEM_CHECK(destroyed == 1);
+}
+
+GEM_TEST(CreateWith_AllocatesFromResource)
+{
+    CountingResource resource;
+    int destroyed = 0;
+    CResourceObject *pObject = nullptr;
+    GEM_CHECK(Gem::Succeeded(CResourceObjectImpl::CreateWith(&resource, &pObject, &destroyed)));
+    GEM_CHECK(pObject != nullptr);
+    GEM_CHECK(resource.Allocations == 1);
+    GEM_CHECK(resource.BytesInUse >= sizeof(CResourceObjectImpl));
+
+    if (pObject)
+    {
+        GEM_CHECK(pObject->AddRef() == 2);
+        GEM_CHECK(pObject->Release() == 1);
+        GEM_CHECK(resource.Deallocations == 0);
+        pObject->Release();
+    }
+
+    GEM_CHECK(destroyed == 1);
+    GEM_CHECK(resource.Deallocations == 1);
+    GEM_CHECK(resource.BytesInUse == 0);
+    GEM_CHECK(resource.MismatchedFrees == 0);
+}
+
+GEM_TEST(CreateWith_InitializeFailureReturnsMemory)
+{
+    CountingResource resource;
+    int destroyed = 0;
+    CResourceObject *pObject = nullptr;
+    GEM_CHECK(CResourceObjectImpl::CreateWith(&resource, &pObject, &destroyed, Gem::Result::Success, Gem::Result::InvalidArg) == Gem::Result::InvalidArg);
+    GEM_CHECK(pObject == nullptr);
+    GEM_CHECK(destroyed == 1);
+    GEM_CHECK(resource.Allocations == 1);
+    GEM_CHECK(resource.Deallocations == 1);
+    GEM_CHECK(resource.BytesInUse == 0);
+    GEM_CHECK(resource.MismatchedFrees == 0);
+}
+
+#if GEM_EXCEPTIONS
+GEM_TEST(CreateWith_ConstructorFailureReturnsMemory)
+{
+    CountingResource resource;
+    int destroyed = 0;
+    CResourceObject *pObject = nullptr;
+    GEM_CHECK(CResourceObjectImpl::CreateWith(&resource, &pObject, &destroyed, Gem::Result::NotFound) == Gem::Result::NotFound);
+    GEM_CHECK(pObject == nullptr);
+    GEM_CHECK(destroyed == 0);
+    GEM_CHECK(resource.Allocations == 1);
+    GEM_CHECK(resource.Deallocations == 1);
+    GEM_CHECK(resource.BytesInUse == 0);
+    GEM_CHECK(resource.MismatchedFrees == 0);
+}
+
+GEM_TEST(CreateWith_ExhaustedResource)
+{
+    CountingResource resource;
+    resource.Exhausted = true;
+    int destroyed = 0;
+    CResourceObject *pObject = nullptr;
+    GEM_CHECK(CResourceObjectImpl::CreateWith(&resource, &pObject, &destroyed) == Gem::Result::OutOfMemory);
+    GEM_CHECK(pObject == nullptr);
+    GEM_CHECK(resource.Allocations == 0);
+    GEM_CHECK(resource.Deallocations == 0);
+}
+#endif
+
+GEM_TEST(CreateWith_NullArguments)
+{
+    CountingResource resource;
+    int destroyed = 0;
+    CResourceObject *pObject = nullptr;
+    GEM_CHECK(CResourceObjectImpl::CreateWith(nullptr, &pObject, &destroyed) == Gem::Result::BadPointer);
+    GEM_CHECK(CResourceObjectImpl::CreateWith(&resource, nullptr, &destroyed) == Gem::Result::BadPointer);
+    GEM_CHECK(resource.Allocations == 0);
+}
+
+// Counts how it was passed along
+struct Tracer
+{
+    int Copies = 0;
+    int Moves = 0;
+
+    Tracer() = default;
+
+    Tracer(const Tracer &other) :
+        Copies(other.Copies + 1),
+        Moves(other.Moves)
+    {
+    }
+
+    Tracer(Tracer &&other) noexcept :
+        Copies(other.Copies),
+        Moves(other.Moves + 1)
+    {
+    }
+};
+
+struct XForwarded : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XForwarded, 0x64E0B2D9C7185A3F);
+};
+
+class CForwarded : public Gem::TGeneric<XForwarded>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XForwarded)
+    END_GEM_INTERFACE_MAP()
+
+    std::unique_ptr<int> m_pOwned;
+    const Tracer &m_ConstRef;
+    Tracer m_Moved;
+
+    CForwarded(std::unique_ptr<int> pOwned, int &out, const Tracer &constRef, Tracer &&moved) :
+        m_pOwned(std::move(pOwned)),
+        m_ConstRef(constRef),
+        m_Moved(std::move(moved))
+    {
+        out = *m_pOwned;
+    }
+
+    void Initialize() {}
+};
+
+using CForwardedImpl = Gem::TGenericImpl<CForwarded>;
+
+void CheckForwarded(Gem::Result result, CForwarded *pObject, const std::unique_ptr<int> &pSource, int out, const Tracer &constRef)
+{
+    GEM_CHECK(Gem::Succeeded(result));
+    GEM_CHECK(pObject != nullptr);
+    if (!pObject)
+    {
+        return;
+    }
+
+    GEM_CHECK(!pSource);
+    GEM_CHECK(pObject->m_pOwned && *pObject->m_pOwned == 5);
+    GEM_CHECK(out == 5);
+    GEM_CHECK(&pObject->m_ConstRef == &constRef);
+
+    // Moved once into the member, never copied
+    GEM_CHECK(pObject->m_Moved.Copies == 0);
+    GEM_CHECK(pObject->m_Moved.Moves == 1);
+    pObject->Release();
+}
+
+GEM_TEST(Create_ForwardsArguments)
+{
+    std::unique_ptr<int> pSource(new int(5));
+    int out = 0;
+    Tracer constRef;
+    Tracer moved;
+    CForwarded *pObject = nullptr;
+    Gem::Result result = CForwardedImpl::Create(&pObject, std::move(pSource), out, constRef, std::move(moved));
+    CheckForwarded(result, pObject, pSource, out, constRef);
+}
+
+GEM_TEST(CreateWith_ForwardsArguments)
+{
+    CountingResource resource;
+    std::unique_ptr<int> pSource(new int(5));
+    int out = 0;
+    Tracer constRef;
+    Tracer moved;
+    CForwarded *pObject = nullptr;
+    Gem::Result result = CForwardedImpl::CreateWith(&resource, &pObject, std::move(pSource), out, constRef, std::move(moved));
+    CheckForwarded(result, pObject, pSource, out, constRef);
+    GEM_CHECK(resource.BytesInUse == 0);
+}
+}
@@ -0,0 +1,63 @@
+//================================================================================================
+// Epoch-based deferred release tests
+//
+// Also built without exceptions as GemTestsNoExceptions. The out-of-memory tests are in
+// TestEpochOutOfMemory.cpp.
+// - A retired object outlives the read guards that could still see it
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemEpoch.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace GemTest
+{
+struct XNode : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XNode, 0x3F81A6D05E2C97B4);
+};
+
+std::atomic<long> s_LiveNodes{0};
+
+class CNode : public Gem::TGeneric<XNode>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XNode)
+    END_GEM_INTERFACE_MAP()
+
+    CNode() { s_LiveNodes.fetch_add(1, std::memory_order_relaxed); }
+    ~CNode() { s_LiveNodes.fetch_sub(1, std::memory_order_relaxed); }
+
+    void Initialize() {}
+};
+
+XNode *MakeNode()
+{
+    CNode *pNode = nullptr;
+    Gem::TGenericImpl<CNode>::Create(&pNode);
+    return pNode;
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(Epoch_RetireUnderGuard)
+{
+    std::thread([]()
+    {
+        XNode *pNode = MakeNode();
+        {
+            Gem::EpochReadGuard guard;
+            Gem::GemRetire(pNode);
+            Gem::GemReclaim();
+            GEM_CHECK(s_LiveNodes.load() == 1);
+        }
+
+        Gem::GemSynchronize();
+        GEM_CHECK(s_LiveNodes.load() == 0);
+    }).join();
+}
+}
@@ -0,0 +1,143 @@
+//================================================================================================
+// Epoch-based deferred release tests with allocations failing
+//
+// Built as its own executable, GemTestsEpochOutOfMemory: it replaces the global operator new,
+// which would affect every other test in the process.
+// - Retiring inside a read guard when the retire list cannot grow defers the release instead
+//   of waiting for the caller's own guard
+// - Reclaiming releases this thread's retired objects and other threads' orphans without
+//   allocating
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemEpoch.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+namespace GemTest
+{
+// Set on a thread to make its operator new calls fail
+thread_local bool t_FailAllocations = false;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    if (GemTest::t_FailAllocations)
+    {
+        return nullptr;
+    }
+
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *p = operator new(size, std::nothrow))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    std::free(p);
+}
+
+namespace GemTest
+{
+struct XNode : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XNode, 0x3F81A6D05E2C97B4);
+};
+
+std::atomic<long> s_LiveNodes{0};
+
+class CNode : public Gem::TGeneric<XNode>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XNode)
+    END_GEM_INTERFACE_MAP()
+
+    CNode() { s_LiveNodes.fetch_add(1, std::memory_order_relaxed); }
+    ~CNode() { s_LiveNodes.fetch_sub(1, std::memory_order_relaxed); }
+
+    void Initialize() {}
+};
+
+XNode *MakeNode()
+{
+    CNode *pNode = nullptr;
+    Gem::TGenericImpl<CNode>::Create(&pNode);
+    return pNode;
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(Epoch_RetireUnderGuardOutOfMemory)
+{
+    // A fresh thread, so the retire list has no capacity and the first retirement allocates
+    std::thread([]()
+    {
+        XNode *pNodes[2] = {MakeNode(), MakeNode()};
+        {
+            Gem::EpochReadGuard guard;
+            t_FailAllocations = true;
+            Gem::GemRetire(pNodes[0]);
+            Gem::GemRetire(pNodes[1]);
+            t_FailAllocations = false;
+
+            // Still reachable by this thread's guard
+            GEM_CHECK(s_LiveNodes.load() == 2);
+        }
+
+        Gem::GemSynchronize();
+        GEM_CHECK(s_LiveNodes.load() == 0);
+    }).join();
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(Epoch_ReclaimOutOfMemory)
+{
+    // Retired under a guard and left behind when the thread exits
+    std::thread([]()
+    {
+        Gem::EpochReadGuard guard;
+        Gem::GemRetire(MakeNode());
+    }).join();
+
+    std::thread([]()
+    {
+        {
+            Gem::EpochReadGuard guard;
+            for (int i = 0; i < 3; ++i)
+            {
+                Gem::GemRetire(MakeNode());
+            }
+        }
+
+        GEM_CHECK(s_LiveNodes.load() == 4);
+
+        t_FailAllocations = true;
+        Gem::GemSynchronize();
+        t_FailAllocations = false;
+        GEM_CHECK(s_LiveNodes.load() == 0);
+    }).join();
+}
+}
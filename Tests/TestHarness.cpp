@@ -0,0 +1,101 @@
+#include "TestHarness.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GemTest
+{
+namespace
+{
+struct RegisteredTest
+{
+    const char *Name;
+    TestFunction Test;
+};
+
+std::vector<RegisteredTest> &Tests()
+{
+    static std::vector<RegisteredTest> tests;
+    return tests;
+}
+
+std::atomic<unsigned> s_Failures{0};
+std::mutex s_OutputMutex;
+
+//------------------------------------------------------------------------------------------------
+void PrintUsage()
+{
+    printf(
+        "Usage: GemTests [options]\n"
+        "  --filter=TEXT        Run only tests whose name contains TEXT\n"
+        "  --list               List tests\n");
+}
+}
+
+//------------------------------------------------------------------------------------------------
+Registration::Registration(const char *name, TestFunction test)
+{
+    Tests().push_back({name, test});
+}
+
+//------------------------------------------------------------------------------------------------
+void ReportFailure(const char *file, int line, const char *expression)
+{
+    s_Failures.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(s_OutputMutex);
+    fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+}
+
+}
+
+//------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *pArg = argv[i];
+        if (strncmp(pArg, "--filter=", 9) == 0)
+        {
+            filter = pArg + 9;
+        }
+        else if (strcmp(pArg, "--list") == 0)
+        {
+            for (const GemTest::RegisteredTest &test : GemTest::Tests())
+            {
+                printf("%s\n", test.Name);
+            }
+            return 0;
+        }
+        else
+        {
+            GemTest::PrintUsage();
+            return strcmp(pArg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    unsigned failedTests = 0;
+    unsigned ranTests = 0;
+    for (const GemTest::RegisteredTest &test : GemTest::Tests())
+    {
+        if (!filter.empty() && std::string(test.Name).find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        unsigned failuresBefore = GemTest::s_Failures.load();
+        test.Test();
+        bool passed = GemTest::s_Failures.load() == failuresBefore;
+        printf("%-60s %s\n", test.Name, passed ? "passed" : "FAILED");
+        failedTests += passed ? 0 : 1;
+        ++ranTests;
+    }
+
+    printf("%u of %u tests passed\n", ranTests - failedTests, ranTests);
+    return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+//================================================================================================
+// GeM test harness
+//
+// Minimal self-contained test runner for the GeM primitives:
+// - Tests are functions registered with GEM_TEST
+// - GEM_CHECK records a failure and continues; it may be used from any thread
+// - GemTests exits with a non-zero code if any check failed, so CTest reports it
+//================================================================================================
+
+#pragma once
+
+namespace GemTest
+{
+using TestFunction = void (*)();
+
+struct Registration
+{
+    Registration(const char *name, TestFunction test);
+};
+
+void ReportFailure(const char *file, int line, const char *expression);
+
+}
+
+// Defines and registers a test
+#define GEM_TEST(name) \
+    static void name(); \
+    static GemTest::Registration s_##name##Registration(#name, name); \
+    static void name()
+
+// Records a failure if condition is false
+#define GEM_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            GemTest::ReportFailure(__FILE__, __LINE__, #condition); \
+        } \
+    } while (false)
@@ -0,0 +1,91 @@
+//================================================================================================
+// Lifecycle trace tests (built with GEM_ENABLE_LIFECYCLE_TRACE)
+//
+// - Events recorded by thread_local destructors that run after the thread's trace buffer is
+//   destroyed still reach the sink
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <cstring>
+#include <thread>
+
+namespace GemTest
+{
+struct XLifecycleTraced : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XLifecycleTraced, 0x3C8E1A7D25F046B9);
+};
+
+class CLifecycleTraced : public Gem::TGeneric<XLifecycleTraced>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XLifecycleTraced)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+// Counts the Destroy events of CLifecycleTraced objects; the tracer serializes calls to Write
+class CDestroyCounter : public Gem::LifecycleTraceSink
+{
+public:
+    size_t m_DestroyCount = 0;
+
+    void Write(const Gem::LifecycleEvent *pEvents, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (std::strcmp(pEvents[i].Name, "Destroy") == 0 &&
+                std::strcmp(pEvents[i].ClassName, "XLifecycleTraced") == 0)
+            {
+                ++m_DestroyCount;
+            }
+        }
+    }
+};
+
+static void CreateAndReleaseTraced()
+{
+    Gem::TGemPtr<CLifecycleTraced> pObject;
+    Gem::TGenericImpl<CLifecycleTraced>::Create(&pObject);
+}
+
+// Creates and releases an object from its destructor, at thread exit
+struct CExitTracer
+{
+    bool m_Armed = false;
+
+    ~CExitTracer()
+    {
+        if (m_Armed)
+        {
+            CreateAndReleaseTraced();
+        }
+    }
+};
+
+static thread_local CExitTracer t_ExitTracer;
+
+GEM_TEST(LifecycleTrace_RecordAfterThreadBufferDestroyed)
+{
+    CDestroyCounter sink;
+    Gem::LifecycleTracer::SetSink(&sink);
+
+    std::thread thread([]
+    {
+        // Constructing t_ExitTracer before the trace buffer makes its destructor run after the
+        // buffer's at thread exit
+        t_ExitTracer.m_Armed = true;
+        CreateAndReleaseTraced();
+    });
+    thread.join();
+
+    Gem::LifecycleTracer::SetSink(nullptr);
+
+    GEM_CHECK(sink.m_DestroyCount == 2);
+}
+}
@@ -0,0 +1,167 @@
+//================================================================================================
+// Plugin manifest registration tests
+//
+// - A stale module whose contents hash is unchanged is registered from the manifest, without
+//   being scanned, and registering the manifest again succeeds
+// - Modules that are missing or clash with another module's class are reported, and the
+//   modules after them are still registered
+//
+// The manifests are written record by record, so their classes differ from what scanning the
+// module files would find.
+//================================================================================================
+
+#include "TestHarness.hpp"
+#include "Plugins/TestPlugin.hpp"
+
+#include <Gem.hpp>
+#include <GemPlugin.hpp>
+#include <GemPluginManifest.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace GemTest
+{
+struct TestManifestModule
+{
+    std::string Path;
+    bool IsStale;
+    uint64_t ClassId;
+};
+
+static std::string TempPath(const char *name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Writes a data file that cannot be loaded as a module
+static void WriteDataFile(const std::string &path)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "Not a module: " << path;
+}
+
+// Writes a manifest with one class per module. Stamps and hashes come from the files, with the
+// modification time shifted for stale modules; missing files get zeros.
+static bool WriteManifest(const std::string &path, const std::vector<TestManifestModule> &modules)
+{
+    std::vector<Gem::PluginManifestModule> records;
+    std::vector<Gem::PluginManifestClass> classes;
+    std::string strings;
+    for (const TestManifestModule &module : modules)
+    {
+        Gem::PluginFileStamp stamp;
+        uint64_t contentHash = 0;
+        Gem::PluginFileStamp::Get(module.Path.c_str(), stamp);
+        Gem::PluginFileStamp::HashContents(module.Path.c_str(), contentHash);
+
+        uint32_t index = static_cast<uint32_t>(records.size());
+        records.push_back({stamp.ModifiedTime + (module.IsStale ? 1 : 0), stamp.FileSize, contentHash,
+            static_cast<uint32_t>(strings.size()), index, 1, 0, 0, 0});
+        classes.push_back({module.ClassId, 0, 0});
+        strings.append(module.Path).push_back('\0');
+    }
+
+    strings.resize((strings.size() + 7) & ~size_t(7), '\0');
+    Gem::PluginManifestHeader header{Gem::PluginManifestHeader::MagicValue, Gem::PluginManifestHeader::CurrentVersion,
+        static_cast<uint32_t>(records.size()), static_cast<uint32_t>(classes.size()), 0, 0, static_cast<uint32_t>(strings.size()), 0};
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(Gem::PluginManifestModule));
+    file.write(reinterpret_cast<const char *>(classes.data()), classes.size() * sizeof(Gem::PluginManifestClass));
+    file.write(strings.data(), strings.size());
+    return file.good();
+}
+
+static bool ProvidesClass(const std::string &modulePath, uint64_t clsid)
+{
+    Gem::PluginLoader::Module *pModule = nullptr;
+    if (Gem::Failed(Gem::PluginLoader::GetModule(modulePath.c_str(), &pModule)))
+    {
+        return false;
+    }
+
+    for (uint64_t moduleClassId : pModule->ClassIds())
+    {
+        if (moduleClassId == clsid)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+GEM_TEST(Manifest_StaleUnchangedModuleIsNotScanned)
+{
+    constexpr uint64_t clsid = Gem::HashInterfaceName("GemTest::ManifestRehashedClass");
+    std::string modulePath = TempPath("GemTestManifestRehashed.bin");
+    std::string manifestPath = TempPath("GemTestManifestRehashed.manifest");
+    WriteDataFile(modulePath);
+    GEM_CHECK(WriteManifest(manifestPath, {{modulePath, true, clsid}}));
+
+    Gem::PluginManifest manifest;
+    GEM_CHECK(Gem::Succeeded(manifest.Open(manifestPath.c_str())));
+
+    // Scanning the data file would fail, so the class can only come from the manifest
+    std::vector<std::string> stalePaths;
+    std::vector<Gem::PluginManifest::ModuleRegisterResult> failures;
+    GEM_CHECK(Gem::Succeeded(manifest.RegisterModules(&stalePaths, &failures)));
+    GEM_CHECK(stalePaths.size() == 1 && stalePaths[0] == modulePath);
+    GEM_CHECK(failures.empty());
+    GEM_CHECK(ProvidesClass(modulePath, clsid));
+
+    // The classes are already registered to the same module
+    GEM_CHECK(Gem::Succeeded(manifest.RegisterModules()));
+
+    manifest.Close();
+    std::error_code error;
+    std::filesystem::remove(manifestPath, error);
+    std::filesystem::remove(modulePath, error);
+}
+
+GEM_TEST(Manifest_FailingModulesAreReportedAndSkipped)
+{
+    constexpr uint64_t missingClassId = Gem::HashInterfaceName("GemTest::ManifestMissingClass");
+    constexpr uint64_t lastClassId = Gem::HashInterfaceName("GemTest::ManifestLastClass");
+    std::string missingPath = TempPath("GemTestManifestMissing.bin");
+    std::string clashPath = TempPath("GemTestManifestClash.bin");
+    std::string lastPath = TempPath("GemTestManifestLast.bin");
+    std::string manifestPath = TempPath("GemTestManifestFailures.manifest");
+    WriteDataFile(clashPath);
+    WriteDataFile(lastPath);
+
+    // TestPluginClassId belongs to the test plugin module
+    std::string pluginPath = std::string(GEM_TEST_PLUGIN_DIR "/GemTestPlugin") + GEM_TEST_PLUGIN_SUFFIX;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(pluginPath.c_str(), {TestPluginClassId})));
+
+    GEM_CHECK(WriteManifest(manifestPath, {{missingPath, false, missingClassId}, {clashPath, false, TestPluginClassId}, {lastPath, false, lastClassId}}));
+
+    Gem::PluginManifest manifest;
+    GEM_CHECK(Gem::Succeeded(manifest.Open(manifestPath.c_str())));
+
+    std::vector<std::string> stalePaths;
+    std::vector<Gem::PluginManifest::ModuleRegisterResult> failures;
+    GEM_CHECK(manifest.RegisterModules(&stalePaths, &failures) == Gem::Result::Fail);
+    GEM_CHECK(stalePaths.size() == 1 && stalePaths[0] == missingPath);
+    GEM_CHECK(failures.size() == 2);
+    if (failures.size() == 2)
+    {
+        GEM_CHECK(failures[0].Path == missingPath && failures[0].Result == Gem::Result::NotFound);
+        GEM_CHECK(failures[1].Path == clashPath && failures[1].Result == Gem::Result::InvalidArg);
+    }
+
+    GEM_CHECK(ProvidesClass(lastPath, lastClassId));
+    GEM_CHECK(ProvidesClass(pluginPath, TestPluginClassId));
+
+    manifest.Close();
+    std::error_code error;
+    std::filesystem::remove(manifestPath, error);
+    std::filesystem::remove(clashPath, error);
+    std::filesystem::remove(lastPath, error);
+}
+}
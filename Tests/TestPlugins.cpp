@@ -0,0 +1,328 @@
+//================================================================================================
+// Plugin loader tests
+//
+// - Missing and corrupt module files fail with PluginLoadFailed, and a library without the
+//   plugin entry points with PluginProcNotFound
+// - A module with live objects stays loaded; once they are released it unloads, and the next
+//   CreateInstance loads it again
+// - After a module is unloaded, CreateInstance fails if its file can no longer be loaded
+// - Registering a module's class again succeeds; registering it for another module fails
+// - A plugin class may unload unused modules while it is being created, and its own module
+//   stays loaded
+// - WarmUp initializes the module providing a required class before the module requiring it,
+//   and a module whose required class is missing fails to initialize
+// - With object tracking, the host's tracker lists plugin objects, and a module's class records
+//   are gone once it unloads
+//
+// The modules are built from Plugins/ into GEM_TEST_PLUGIN_DIR.
+//================================================================================================
+
+#include "TestHarness.hpp"
+#include "Plugins/TestPlugin.hpp"
+
+#include <Gem.hpp>
+#include <GemPlugin.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GemTest
+{
+std::string TestPluginPath(const char *name)
+{
+    return std::string(GEM_TEST_PLUGIN_DIR "/") + name + GEM_TEST_PLUGIN_SUFFIX;
+}
+
+std::string TempPluginPath(const char *name)
+{
+    return (std::filesystem::temp_directory_path() / (std::string(name) + GEM_TEST_PLUGIN_SUFFIX)).string();
+}
+
+void WriteGarbage(const std::string &path)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "This is not a shared library";
+}
+
+Gem::Result CreateTestService(uint64_t clsid)
+{
+    Gem::TGemPtr<XTestPluginService> pService;
+    Gem::Result result = Gem::CreateInstance(clsid, GEM_IID_PPV_ARGS(&pService));
+    if (Gem::Succeeded(result) && pService->Answer() != 42)
+    {
+        return Gem::Result::Fail;
+    }
+
+    return result;
+}
+
+GEM_TEST(Plugin_MissingFileFailsToLoad)
+{
+    constexpr uint64_t clsid = Gem::HashInterfaceName("GemTest::MissingPluginClass");
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestPluginMissing").c_str(), {clsid})));
+
+    // A failed load is retried, and fails again
+    GEM_CHECK(CreateTestService(clsid) == Gem::Result::PluginLoadFailed);
+    GEM_CHECK(CreateTestService(clsid) == Gem::Result::PluginLoadFailed);
+}
+
+GEM_TEST(Plugin_CorruptFileFailsToLoad)
+{
+    constexpr uint64_t clsid = Gem::HashInterfaceName("GemTest::CorruptPluginClass");
+    std::string path = TempPluginPath("GemTestPluginCorrupt");
+    WriteGarbage(path);
+
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(path.c_str(), {clsid})));
+    GEM_CHECK(CreateTestService(clsid) == Gem::Result::PluginLoadFailed);
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+GEM_TEST(Plugin_MissingEntryPoint)
+{
+    constexpr uint64_t clsid = Gem::HashInterfaceName("GemTest::NoEntryPluginClass");
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestPluginNoEntry").c_str(), {clsid}, &pModule)));
+    GEM_CHECK(CreateTestService(clsid) == Gem::Result::PluginProcNotFound);
+    GEM_CHECK(pModule && !pModule->IsLoaded());
+}
+
+GEM_TEST(Plugin_UnloadAndReload)
+{
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestPlugin").c_str(), {TestPluginClassId}, &pModule)));
+    if (!pModule)
+    {
+        return;
+    }
+
+    {
+        Gem::TGemPtr<XTestPluginService> pService;
+        GEM_CHECK(Gem::Succeeded(Gem::CreateInstance(TestPluginClassId, GEM_IID_PPV_ARGS(&pService))));
+        GEM_CHECK(pModule->IsLoaded());
+
+        // Live objects keep the module loaded
+        Gem::PluginLoader::UnloadUnusedModules();
+        GEM_CHECK(pModule->IsLoaded());
+        GEM_CHECK(pService->Answer() == 42);
+    }
+
+    GEM_CHECK(Gem::PluginLoader::UnloadUnusedModules() >= 1);
+    GEM_CHECK(!pModule->IsLoaded());
+
+    GEM_CHECK(Gem::Succeeded(CreateTestService(TestPluginClassId)));
+    GEM_CHECK(pModule->IsLoaded());
+
+    Gem::PluginLoader::UnloadUnusedModules();
+    GEM_CHECK(!pModule->IsLoaded());
+}
+
+GEM_TEST(Plugin_CreateFailsAfterUnloadWhenFileIsGone)
+{
+    std::string path = TempPluginPath("GemTestPluginCopy");
+    std::error_code error;
+    std::filesystem::copy_file(TestPluginPath("GemTestPlugin"), path, std::filesystem::copy_options::overwrite_existing, error);
+    GEM_CHECK(!error);
+
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(path.c_str(), {TestPluginCopyClassId}, &pModule)));
+    GEM_CHECK(Gem::Succeeded(CreateTestService(TestPluginCopyClassId)));
+
+    Gem::PluginLoader::UnloadUnusedModules();
+    GEM_CHECK(pModule && !pModule->IsLoaded());
+
+    // Replace the file so it can no longer be loaded
+    std::filesystem::remove(path, error);
+    WriteGarbage(path);
+    GEM_CHECK(CreateTestService(TestPluginCopyClassId) == Gem::Result::PluginLoadFailed);
+
+    std::filesystem::remove(path, error);
+    GEM_CHECK(CreateTestService(TestPluginCopyClassId) == Gem::Result::PluginLoadFailed);
+}
+
+GEM_TEST(Plugin_RegisterModuleClassTwice)
+{
+    std::string path = TestPluginPath("GemTestPlugin");
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(path.c_str(), {TestPluginClassId}, &pModule)));
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(path.c_str(), {TestPluginClassId})));
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModuleClass(pModule, TestPluginClassId)));
+
+    std::vector<uint64_t> classIds = pModule->ClassIds();
+    GEM_CHECK(std::count(classIds.begin(), classIds.end(), TestPluginClassId) == 1);
+
+    // The class belongs to the first module
+    GEM_CHECK(Gem::PluginLoader::RegisterModule(TempPluginPath("GemTestPluginOther").c_str(), {TestPluginClassId}) == Gem::Result::InvalidArg);
+}
+
+static void UnloadDuringCreate()
+{
+    Gem::PluginLoader::UnloadUnusedModules();
+}
+
+GEM_TEST(Plugin_UnloadDuringCreate)
+{
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestPlugin").c_str(), {TestPluginClassId}, &pModule)));
+
+    Gem::TGemPtr<XTestPluginService> pService;
+    GEM_CHECK(Gem::Succeeded(Gem::CreateInstance(TestPluginClassId, GEM_IID_PPV_ARGS(&pService))));
+    if (!pService)
+    {
+        return;
+    }
+
+    // The hooked creation unloads modules from inside the module's factory
+    pService->SetCreateHook(&UnloadDuringCreate);
+    Gem::TGemPtr<XTestPluginService> pHooked;
+    GEM_CHECK(Gem::Succeeded(Gem::CreateInstance(TestPluginClassId, GEM_IID_PPV_ARGS(&pHooked))));
+    pHooked->SetCreateHook(nullptr);
+    GEM_CHECK(pModule->IsLoaded());
+
+    pService = nullptr;
+    pHooked = nullptr;
+    Gem::PluginLoader::UnloadUnusedModules();
+    GEM_CHECK(!pModule->IsLoaded());
+}
+
+static std::mutex s_InitLogMutex;
+static std::vector<int> s_InitLog;
+
+class CTestInitLog : public Gem::TGeneric<XTestInitLog>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XTestInitLog)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+
+    GEMMETHODIMP_(void) Append(int moduleIndex) override
+    {
+        std::lock_guard<std::mutex> lock(s_InitLogMutex);
+        s_InitLog.push_back(moduleIndex);
+    }
+};
+
+GEM_REGISTER_CLASS(TestInitLogClassId, CTestInitLog);
+
+static std::vector<int> TakeInitLog()
+{
+    std::lock_guard<std::mutex> lock(s_InitLogMutex);
+    return std::move(s_InitLog);
+}
+
+static Gem::Result ModuleResult(const std::vector<Gem::PluginLoader::ModuleLoadResult> &results, Gem::PluginLoader::Module *pModule)
+{
+    for (const Gem::PluginLoader::ModuleLoadResult &moduleResult : results)
+    {
+        if (moduleResult.pModule == pModule)
+        {
+            return moduleResult.Result;
+        }
+    }
+
+    return Gem::Result::NotFound;
+}
+
+GEM_TEST(Plugin_WarmUpInitializesRequiredModulesFirst)
+{
+    Gem::PluginLoader::Module *pProvider = nullptr;
+    Gem::PluginLoader::Module *pDependent = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestInitPlugin0").c_str(), {TestInitPluginClassId(0)}, &pProvider)));
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestInitPlugin1").c_str(), {TestInitPluginClassId(1)}, &pDependent)));
+    if (!pProvider || !pDependent)
+    {
+        return;
+    }
+
+    // Registered by hand, so the requirement is declared by hand
+    pDependent->AddRequiredClass(TestInitPluginClassId(0));
+
+    for (unsigned threads : {1u, 4u})
+    {
+        // Loaded modules are not initialized again
+        Gem::PluginLoader::UnloadUnusedModules();
+        TakeInitLog();
+
+        std::vector<Gem::PluginLoader::ModuleLoadResult> results;
+        Gem::PluginLoader::WarmUp(threads, &results);
+        GEM_CHECK(ModuleResult(results, pProvider) == Gem::Result::Success);
+        GEM_CHECK(ModuleResult(results, pDependent) == Gem::Result::Success);
+
+        // Without the ordering, the dependent module would log first and load the provider
+        // from inside its own initialization
+        std::vector<int> log = TakeInitLog();
+        auto provider = std::find(log.begin(), log.end(), 0);
+        auto dependent = std::find(log.begin(), log.end(), 1);
+        GEM_CHECK(std::count(log.begin(), log.end(), 0) == 1);
+        GEM_CHECK(std::count(log.begin(), log.end(), 1) == 1);
+        GEM_CHECK(provider < dependent);
+    }
+
+    Gem::PluginLoader::UnloadUnusedModules();
+}
+
+GEM_TEST(Plugin_WarmUpFailsWhenRequiredClassIsMissing)
+{
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestInitPlugin2").c_str(), {TestInitPluginClassId(2)}, &pModule)));
+    if (!pModule)
+    {
+        return;
+    }
+
+    pModule->AddRequiredClass(TestMissingClassId);
+
+    // The module's initialization cannot create the missing class, so the load fails with the
+    // result of that creation
+    std::vector<Gem::PluginLoader::ModuleLoadResult> results;
+    GEM_CHECK(Gem::PluginLoader::WarmUp(0, &results) == Gem::Result::Fail);
+    GEM_CHECK(ModuleResult(results, pModule) == Gem::Result::NotFound);
+    GEM_CHECK(!pModule->IsLoaded());
+    GEM_CHECK(CreateTestService(TestInitPluginClassId(2)) == Gem::Result::NotFound);
+
+    Gem::PluginLoader::UnloadUnusedModules();
+    TakeInitLog();
+}
+
+#ifdef GEM_ENABLE_OBJECT_TRACKING
+// Live objects of every tracked class named name, or -1 if none is tracked
+int64_t TrackedLive(const char *name)
+{
+    int64_t live = -1;
+    for (const Gem::TrackedClassStats &stats : Gem::ObjectTracker::Snapshot())
+    {
+        if (std::string(stats.Name) == name)
+        {
+            live = std::max<int64_t>(live, 0) + stats.Live;
+        }
+    }
+
+    return live;
+}
+
+GEM_TEST(Plugin_ObjectsAreTrackedByHost)
+{
+    Gem::PluginLoader::Module *pModule = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::PluginLoader::RegisterModule(TestPluginPath("GemTestPlugin").c_str(), {TestPluginClassId}, &pModule)));
+    Gem::PluginLoader::UnloadUnusedModules();
+
+    {
+        Gem::TGemPtr<XTestPluginService> pService;
+        GEM_CHECK(Gem::Succeeded(Gem::CreateInstance(TestPluginClassId, GEM_IID_PPV_ARGS(&pService))));
+        GEM_CHECK(TrackedLive("XTestPluginService") == 1);
+    }
+
+    GEM_CHECK(TrackedLive("XTestPluginService") == 0);
+    GEM_CHECK(Gem::PluginLoader::UnloadUnusedModules() >= 1);
+    GEM_CHECK(pModule && !pModule->IsLoaded());
+    GEM_CHECK(TrackedLive("XTestPluginService") == -1);
+}
+#endif
+}
@@ -0,0 +1,196 @@
+//================================================================================================
+// Object pool tests
+//
+// Each test uses its own pooled class, so it sees its own TObjectPool statistics.
+// - A released block is reused by the next creation, and the Live/Free/Slabs counts follow
+// - Creating more objects than a slab holds carves another slab; releasing them returns every
+//   block to the free lists
+// - Objects created on one thread and released on another flow back through the shared lists,
+//   so a producer/consumer pair keeps reusing the same slabs
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+#include <GemPool.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GemTest
+{
+struct XPooled : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XPooled, 0x1F6D94B8E27C03A5);
+};
+
+template<int _Tag>
+class TPooled : public Gem::TGeneric<XPooled>
+{
+    int m_Payload[4] = {};
+
+public:
+    GEM_POOLED_ALLOCATION(TPooled)
+
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XPooled)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+template<class _Class>
+struct TPoolTraits
+{
+    using Pool = Gem::TObjectPool<_Class>;
+    static constexpr size_t BlockSize = (sizeof(Gem::TGenericImpl<_Class>) + Pool::Granularity - 1) / Pool::Granularity * Pool::Granularity;
+    static constexpr size_t BlocksPerSlab = Pool::SlabSize / BlockSize;
+};
+
+using CPooledReuse = TPooled<0>;
+using CPooledGrowth = TPooled<1>;
+using CPooledCrossThread = TPooled<2>;
+
+GEM_TEST(Pool_ReuseAfterRelease)
+{
+    using Pool = Gem::TObjectPool<CPooledReuse>;
+
+    CPooledReuse *pFirst = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPooledReuse>::Create(&pFirst)));
+    Gem::PoolStats stats = Pool::GetStats();
+    GEM_CHECK(stats.Live == 1);
+    GEM_CHECK(stats.Slabs == 1);
+    GEM_CHECK(stats.Free == TPoolTraits<CPooledReuse>::BlocksPerSlab - 1);
+
+    void *pAddress = pFirst;
+    pFirst->Release();
+    stats = Pool::GetStats();
+    GEM_CHECK(stats.Live == 0);
+    GEM_CHECK(stats.Free == TPoolTraits<CPooledReuse>::BlocksPerSlab);
+
+    // The thread cache hands the block just freed straight back
+    CPooledReuse *pSecond = nullptr;
+    GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPooledReuse>::Create(&pSecond)));
+    GEM_CHECK(pSecond == pAddress);
+    stats = Pool::GetStats();
+    GEM_CHECK(stats.Live == 1);
+    GEM_CHECK(stats.Slabs == 1);
+
+    if (pSecond)
+    {
+        pSecond->Release();
+    }
+}
+
+GEM_TEST(Pool_SlabGrowth)
+{
+    using Pool = Gem::TObjectPool<CPooledGrowth>;
+    constexpr size_t BlocksPerSlab = TPoolTraits<CPooledGrowth>::BlocksPerSlab;
+
+    std::vector<Gem::TGemPtr<CPooledGrowth>> objects(BlocksPerSlab + 1);
+    for (Gem::TGemPtr<CPooledGrowth> &pObject : objects)
+    {
+        GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPooledGrowth>::Create(&pObject)));
+    }
+
+    Gem::PoolStats stats = Pool::GetStats();
+    GEM_CHECK(stats.Live == BlocksPerSlab + 1);
+    GEM_CHECK(stats.Slabs == 2);
+    GEM_CHECK(stats.Free == BlocksPerSlab - 1);
+
+    objects.clear();
+    stats = Pool::GetStats();
+    GEM_CHECK(stats.Live == 0);
+    GEM_CHECK(stats.Slabs == 2);
+    GEM_CHECK(stats.Free == 2 * BlocksPerSlab);
+
+    // Slabs are kept, so creating as many again needs no new one
+    objects.resize(BlocksPerSlab + 1);
+    for (Gem::TGemPtr<CPooledGrowth> &pObject : objects)
+    {
+        GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPooledGrowth>::Create(&pObject)));
+    }
+
+    GEM_CHECK(Pool::GetStats().Slabs == 2);
+}
+
+GEM_TEST(Pool_CrossThreadFree)
+{
+    using Pool = Gem::TObjectPool<CPooledCrossThread>;
+    constexpr size_t BlocksPerSlab = TPoolTraits<CPooledCrossThread>::BlocksPerSlab;
+    constexpr int ObjectCount = 20000;
+    constexpr size_t MaxQueued = 256;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<CPooledCrossThread *> queue;
+    bool done = false;
+
+    std::thread producer([&]()
+    {
+        for (int i = 0; i < ObjectCount; ++i)
+        {
+            CPooledCrossThread *pObject = nullptr;
+            GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPooledCrossThread>::Create(&pObject)));
+
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return queue.size() < MaxQueued; });
+            queue.push_back(pObject);
+            changed.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        changed.notify_all();
+    });
+
+    std::thread consumer([&]()
+    {
+        for (;;)
+        {
+            CPooledCrossThread *pObject;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return !queue.empty() || done; });
+                if (queue.empty())
+                {
+                    return;
+                }
+
+                pObject = queue.front();
+                queue.pop_front();
+                changed.notify_all();
+            }
+
+            if (pObject)
+            {
+                pObject->Release();
+            }
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    // Blocks freed on the consumer went back to the producer, so far fewer slabs than
+    // ObjectCount blocks were carved; the exited threads' caches are back in the shared lists
+    Gem::PoolStats stats = Pool::GetStats();
+    GEM_CHECK(stats.Live == 0);
+    GEM_CHECK(stats.Slabs * BlocksPerSlab < ObjectCount / 4);
+    GEM_CHECK(stats.Free == stats.Slabs * BlocksPerSlab);
+
+    // Blocks freed on other threads are reused here
+    size_t slabs = stats.Slabs;
+    std::vector<Gem::TGemPtr<CPooledCrossThread>> objects(stats.Free);
+    for (Gem::TGemPtr<CPooledCrossThread> &pObject : objects)
+    {
+        GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPooledCrossThread>::Create(&pObject)));
+    }
+
+    GEM_CHECK(Pool::GetStats().Slabs == slabs);
+}
+}
@@ -0,0 +1,193 @@
+//================================================================================================
+// Interface map and query cache tests
+//
+// - Borrowed queries lend only interfaces stored inside the object
+// - TQueryCache returns each object's own interface, and never caches separately allocated ones
+// - TQueryCache::QueryInterface falls back to the object's QueryInterface for interfaces a
+//   borrowed query cannot lend
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <memory>
+
+namespace GemTest
+{
+struct XOuter : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XOuter, 0x2E5A91C7D40B63F8);
+};
+
+struct XInner : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XInner, 0x91D3B6047A2E5FC1);
+};
+
+class CInner : public Gem::TGeneric<XInner>
+{
+};
+
+// Aggregate stored as a member
+class CMemberOuter : public Gem::TGeneric<XOuter>
+{
+    Gem::TAggregate<CInner, CMemberOuter> m_inner{this};
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_AGGREGATE(XInner, &m_inner)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+// Aggregate allocated separately
+class CPointerOuter : public Gem::TGeneric<XOuter>
+{
+    std::unique_ptr<Gem::TAggregate<CInner, CPointerOuter>> m_pInner{new Gem::TAggregate<CInner, CPointerOuter>(this)};
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_AGGREGATE(XInner, m_pInner.get())
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+class CLazyOuter : public Gem::TGeneric<XOuter>
+{
+    Gem::TLazyAggregate<CInner, CLazyOuter> m_inner;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_LAZY_AGGREGATE(XInner, m_inner)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+struct XFeature : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XFeature, 0x4B8F2D61E09A7C35);
+};
+
+class CTearOffOuter;
+
+class CFeatureTearOff : public Gem::TTearOff<XFeature, CTearOffOuter>
+{
+public:
+    using TTearOff::TTearOff;
+};
+
+class CTearOffOuter : public Gem::TGeneric<XOuter>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XOuter)
+        GEM_INTERFACE_ENTRY_TEAROFF(XFeature, CFeatureTearOff)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+template<class _Outer>
+Gem::TGemPtr<XInner> OwnedInner(_Outer *pOuter)
+{
+    Gem::TGemPtr<XInner> pInner;
+    pOuter->QueryInterface(&pInner);
+    return pInner;
+}
+
+// Queries two instances of _Outer through one cache
+template<class _Outer>
+void CheckCacheAcrossInstances(bool expectBorrowable)
+{
+    Gem::TGemPtr<_Outer> pFirst;
+    Gem::TGemPtr<_Outer> pSecond;
+    GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<_Outer>::Create(&pFirst)));
+    GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<_Outer>::Create(&pSecond)));
+
+    Gem::TGemPtr<XInner> pFirstInner = OwnedInner(pFirst.Get());
+    Gem::TGemPtr<XInner> pSecondInner = OwnedInner(pSecond.Get());
+    GEM_CHECK(pFirstInner && pSecondInner && pFirstInner.Get() != pSecondInner.Get());
+
+    Gem::TQueryCache<XInner> cache;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        XInner *pFromFirst = cache.TryAs(static_cast<XOuter *>(pFirst.Get()));
+        XInner *pFromSecond = cache.TryAs(static_cast<XOuter *>(pSecond.Get()));
+        if (expectBorrowable)
+        {
+            GEM_CHECK(pFromFirst == pFirstInner.Get());
+            GEM_CHECK(pFromSecond == pSecondInner.Get());
+        }
+        else
+        {
+            GEM_CHECK(pFromFirst == nullptr);
+            GEM_CHECK(pFromSecond == nullptr);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(QueryInterface_BorrowedAggregates)
+{
+    Gem::TGemPtr<CMemberOuter> pMember;
+    Gem::TGenericImpl<CMemberOuter>::Create(&pMember);
+    GEM_CHECK(pMember->TryAs<XInner>().Get() == OwnedInner(pMember.Get()).Get());
+
+    Gem::TGemPtr<CPointerOuter> pPointer;
+    Gem::TGenericImpl<CPointerOuter>::Create(&pPointer);
+    GEM_CHECK(!pPointer->TryAs<XInner>());
+    GEM_CHECK(OwnedInner(pPointer.Get()));
+
+    Gem::TGemPtr<CLazyOuter> pLazy;
+    Gem::TGenericImpl<CLazyOuter>::Create(&pLazy);
+    void *pBorrowed = nullptr;
+    GEM_CHECK(pLazy->QueryInterfaceBorrowed(XInner::IId, &pBorrowed) == Gem::Result::NoInterface);
+    GEM_CHECK(pBorrowed == nullptr);
+    GEM_CHECK(OwnedInner(pLazy.Get()));
+    GEM_CHECK(!pLazy->TryAs<XInner>());
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(QueryCache_TwoInstances)
+{
+    CheckCacheAcrossInstances<CMemberOuter>(true);
+    CheckCacheAcrossInstances<CPointerOuter>(false);
+    CheckCacheAcrossInstances<CLazyOuter>(false);
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(QueryCache_OwningQueryFallsBack)
+{
+    Gem::TGemPtr<CTearOffOuter> pOuter;
+    GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CTearOffOuter>::Create(&pOuter)));
+
+    Gem::TQueryCache<XFeature> cache;
+    GEM_CHECK(!cache.TryAs(static_cast<XOuter *>(pOuter.Get())));
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        Gem::TGemPtr<XFeature> pFeature;
+        GEM_CHECK(Gem::Succeeded(cache.QueryInterface(static_cast<XOuter *>(pOuter.Get()), &pFeature)));
+        GEM_CHECK(pFeature && pFeature.Get() != static_cast<void *>(pOuter.Get()));
+    }
+
+    Gem::TGemPtr<CPointerOuter> pPointer;
+    GEM_CHECK(Gem::Succeeded(Gem::TGenericImpl<CPointerOuter>::Create(&pPointer)));
+    Gem::TQueryCache<XInner> innerCache;
+    Gem::TGemPtr<XInner> pInner;
+    GEM_CHECK(Gem::Succeeded(innerCache.QueryInterface(static_cast<XOuter *>(pPointer.Get()), &pInner)));
+    GEM_CHECK(pInner.Get() == OwnedInner(pPointer.Get()).Get());
+
+    Gem::TQueryCache<XInner> missingCache;
+    Gem::TGemPtr<XInner> pMissing;
+    GEM_CHECK(missingCache.QueryInterface(static_cast<XOuter *>(pOuter.Get()), &pMissing) == Gem::Result::NoInterface);
+    GEM_CHECK(!pMissing);
+}
+
+}
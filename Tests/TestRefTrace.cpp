@@ -0,0 +1,160 @@
+//================================================================================================
+// Reference count tracing tests (built with GEM_ENABLE_REFCOUNT_TRACING)
+//
+// - Resolving a weak reference traces the strong reference it adds, so the trace stays balanced
+// - Objects released through BiasedThreadModel's queued merge are traced as destroyed
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace GemTest
+{
+struct XWeakTraced : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XWeakTraced, 0x6A0E4D2B18C57F93);
+};
+
+struct XBiasedTraced : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XBiasedTraced, 0x1B93F7C5062DA4E8);
+};
+
+class CWeakTraced : public Gem::TGeneric<XWeakTraced>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XWeakTraced)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+class CBiasedTraced : public Gem::TGeneric<XBiasedTraced>
+{
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XBiasedTraced)
+    END_GEM_INTERFACE_MAP()
+
+    void Initialize() {}
+};
+
+struct TraceCounts
+{
+    size_t AddRefs = 0;
+    size_t Releases = 0;
+    size_t Destroys = 0;
+};
+
+// Dumps the trace and counts the operations recorded for objects of the named class
+TraceCounts CountTrace(const char *className)
+{
+    TraceCounts counts;
+    std::FILE *pFile = std::tmpfile();
+    GEM_CHECK(pFile && Gem::RefCountTracer::Dump(pFile));
+    if (!pFile)
+    {
+        return counts;
+    }
+
+    std::rewind(pFile);
+    Gem::RefTraceFileHeader header{};
+    bool ok = std::fread(&header, sizeof(header), 1, pFile) == 1;
+
+    uint32_t classIndex = UINT32_MAX;
+    for (uint32_t i = 0; ok && i < header.ClassCount; ++i)
+    {
+        uint32_t length = 0;
+        ok = std::fread(&length, sizeof(length), 1, pFile) == 1;
+        std::string name(length, '\0');
+        ok = ok && std::fread(name.data(), 1, length, pFile) == length;
+        if (name == className)
+        {
+            classIndex = i;
+        }
+    }
+
+    for (uint32_t i = 0; ok && i < header.BufferCount; ++i)
+    {
+        uint32_t bufferHeader[2];
+        uint64_t count = 0;
+        ok = std::fread(bufferHeader, sizeof(bufferHeader), 1, pFile) == 1 && std::fread(&count, sizeof(count), 1, pFile) == 1;
+        for (uint64_t j = 0; ok && j < count; ++j)
+        {
+            Gem::RefTraceRecord record;
+            ok = std::fread(&record, sizeof(record), 1, pFile) == 1;
+            if (!ok || record.ClassIndex != classIndex)
+            {
+                continue;
+            }
+
+            switch (static_cast<Gem::RefTraceOp>(record.Op))
+            {
+            case Gem::RefTraceOp::AddRef: ++counts.AddRefs; break;
+            case Gem::RefTraceOp::Release: ++counts.Releases; break;
+            case Gem::RefTraceOp::Destroy: ++counts.Destroys; break;
+            case Gem::RefTraceOp::QueryInterface: break;
+            }
+        }
+    }
+
+    GEM_CHECK(ok);
+    std::fclose(pFile);
+    return counts;
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(RefTrace_WeakResolveIsBalanced)
+{
+    Gem::RefCountTracer::TraceClass("XWeakTraced");
+    {
+        Gem::TGemPtr<CWeakTraced> pObj;
+        Gem::TGenericImpl<CWeakTraced, Gem::WeakReferenceThreadModel>::Create(&pObj);
+
+        Gem::TGemPtr<Gem::XWeakReference> pWeak;
+        GEM_CHECK(Gem::Succeeded(pObj->TryAs<Gem::XWeakReferenceSource>()->GetWeakReference(&pWeak)));
+
+        Gem::TGemPtr<XWeakTraced> pResolved;
+        GEM_CHECK(Gem::Succeeded(pWeak->Resolve(GEM_IID_PPV_ARGS(&pResolved))));
+        GEM_CHECK(pResolved);
+    }
+    Gem::RefCountTracer::StopTracing();
+
+    TraceCounts counts = CountTrace("XWeakTraced");
+    GEM_CHECK(counts.AddRefs > 0);
+    GEM_CHECK(counts.AddRefs == counts.Releases);
+    GEM_CHECK(counts.Destroys == 1);
+}
+
+//------------------------------------------------------------------------------------------------
+GEM_TEST(RefTrace_BiasedQueuedReleaseIsDestroyed)
+{
+    Gem::RefCountTracer::TraceClass("XBiasedTraced");
+
+    // The last reference is dropped on another thread while the owner is attached, so the
+    // release is queued and finished when the owner thread exits
+    std::thread([]()
+    {
+        CBiasedTraced *pObj = nullptr;
+        Gem::TGenericImpl<CBiasedTraced, Gem::BiasedThreadModel>::Create(&pObj);
+        std::thread([pObj]() { pObj->AddRef(); }).join();
+        pObj->Release();
+        std::thread([pObj]() { pObj->Release(); }).join();
+    }).join();
+
+    Gem::RefCountTracer::StopTracing();
+
+    TraceCounts counts = CountTrace("XBiasedTraced");
+    GEM_CHECK(counts.AddRefs == counts.Releases);
+    GEM_CHECK(counts.Destroys == 1);
+}
+
+}
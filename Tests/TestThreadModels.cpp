@@ -0,0 +1,189 @@
+//================================================================================================
+// Threading model tests
+//
+// BiasedThreadModel:
+// - AddRef and Release on the owner thread and on other threads keep the object alive until the
+//   last reference is released
+// - A final release on another thread of a reference the owner took is deferred until the owner
+//   calls ProcessQueuedReleases, and destroys the object exactly once
+// - Releases on other threads racing the owner's own releases destroy the object exactly once
+// - Once the owner thread has exited, another thread's final release destroys the object
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace GemTest
+{
+struct XBiased : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XBiased, 0x6C1F0A83D95E27B4);
+};
+
+class CBiased : public Gem::TGeneric<XBiased>
+{
+    std::atomic<int> *m_pDestroyed;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XBiased)
+    END_GEM_INTERFACE_MAP()
+
+    explicit CBiased(std::atomic<int> *pDestroyed) :
+        m_pDestroyed(pDestroyed)
+    {
+    }
+
+    ~CBiased()
+    {
+        m_pDestroyed->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Initialize() {}
+};
+
+using CBiasedImpl = Gem::TGenericImpl<CBiased, Gem::BiasedThreadModel>;
+
+GEM_TEST(Biased_OwnerAndOtherThreadCounts)
+{
+    std::atomic<int> destroyed{0};
+    CBiased *pObject = nullptr;
+    GEM_CHECK(Gem::Succeeded(CBiasedImpl::Create(&pObject, &destroyed)));
+    if (!pObject)
+    {
+        return;
+    }
+
+    GEM_CHECK(pObject->AddRef() == 2);
+
+    std::thread other([&]()
+    {
+        // References taken and released on another thread use the shared count
+        for (int i = 0; i < 100; ++i)
+        {
+            pObject->AddRef();
+        }
+
+        for (int i = 0; i < 100; ++i)
+        {
+            pObject->Release();
+        }
+    });
+    other.join();
+
+    GEM_CHECK(destroyed.load() == 0);
+    GEM_CHECK(pObject->Release() == 1);
+    GEM_CHECK(destroyed.load() == 0);
+    GEM_CHECK(pObject->Release() == 0);
+    GEM_CHECK(destroyed.load() == 1);
+}
+
+GEM_TEST(Biased_OtherThreadFinalReleaseIsDeferred)
+{
+    std::atomic<int> destroyed{0};
+    Gem::TGemPtr<CBiased> pObject;
+    GEM_CHECK(Gem::Succeeded(CBiasedImpl::Create(&pObject, &destroyed)));
+
+    // The owner's only reference, released elsewhere
+    std::thread other([pMoved = std::move(pObject)]() mutable
+    {
+        pMoved = nullptr;
+    });
+    other.join();
+
+    GEM_CHECK(destroyed.load() == 0);
+    Gem::BiasedThreadModel::ProcessQueuedReleases();
+    GEM_CHECK(destroyed.load() == 1);
+
+    Gem::BiasedThreadModel::ProcessQueuedReleases();
+    GEM_CHECK(destroyed.load() == 1);
+}
+
+GEM_TEST(Biased_OtherThreadReleasesRaceOwner)
+{
+    constexpr int ThreadCount = 4;
+    constexpr int Rounds = 200;
+    constexpr int ReferencesPerThread = 16;
+
+    for (int round = 0; round < Rounds; ++round)
+    {
+        std::atomic<int> destroyed{0};
+        CBiased *pObject = nullptr;
+        GEM_CHECK(Gem::Succeeded(CBiasedImpl::Create(&pObject, &destroyed)));
+        if (!pObject)
+        {
+            return;
+        }
+
+        // Owner references, each released on another thread
+        for (int i = 0; i < ThreadCount * ReferencesPerThread; ++i)
+        {
+            pObject->AddRef();
+        }
+
+        std::atomic<bool> start{false};
+        std::atomic<int> finished{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < ThreadCount; ++t)
+        {
+            threads.emplace_back([&]()
+            {
+                while (!start.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                for (int i = 0; i < ReferencesPerThread; ++i)
+                {
+                    // A reference of the thread's own, then one of the owner's
+                    pObject->AddRef();
+                    pObject->Release();
+                    pObject->Release();
+                }
+
+                finished.fetch_add(1);
+            });
+        }
+
+        start.store(true, std::memory_order_release);
+
+        // The owner drops its own reference while the others release theirs. On odd rounds it
+        // also drains its queue while they run; on even rounds only after they finish.
+        pObject->Release();
+        while (round % 2 && finished.load() < ThreadCount)
+        {
+            Gem::BiasedThreadModel::ProcessQueuedReleases();
+            std::this_thread::yield();
+        }
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        Gem::BiasedThreadModel::ProcessQueuedReleases();
+        GEM_CHECK(destroyed.load() == 1);
+    }
+}
+
+GEM_TEST(Biased_ReleaseAfterOwnerExits)
+{
+    std::atomic<int> destroyed{0};
+    Gem::TGemPtr<CBiased> pObject;
+    std::thread owner([&]()
+    {
+        GEM_CHECK(Gem::Succeeded(CBiasedImpl::Create(&pObject, &destroyed)));
+    });
+    owner.join();
+
+    // Nobody processes the exited owner's queue, so this release merges the counts itself
+    GEM_CHECK(destroyed.load() == 0);
+    pObject = nullptr;
+    GEM_CHECK(destroyed.load() == 1);
+}
+}
@@ -0,0 +1,175 @@
+//================================================================================================
+// Weak reference tests
+//
+// - Resolve returns the object while a strong reference exists, and null after the last one is
+//   released
+// - Resolve racing the final Release either returns a live object or null, and the object is
+//   destroyed exactly once
+// - The side block outlives the object for as long as weak references exist, and is freed by
+//   whichever of the object and the last weak reference goes last
+//================================================================================================
+
+#include "TestHarness.hpp"
+
+#include <Gem.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace GemTest
+{
+struct XWeakTarget : public Gem::XGeneric
+{
+    GEM_INTERFACE_DECLARE(XWeakTarget, 0x3A8E57C10F6B92D4);
+
+    GEMMETHOD_(int, Value)() = 0;
+};
+
+class CWeakTarget : public Gem::TGeneric<XWeakTarget>
+{
+    std::atomic<int> *m_pDestroyed;
+
+public:
+    BEGIN_GEM_INTERFACE_MAP()
+        GEM_INTERFACE_ENTRY(XWeakTarget)
+    END_GEM_INTERFACE_MAP()
+
+    explicit CWeakTarget(std::atomic<int> *pDestroyed) :
+        m_pDestroyed(pDestroyed)
+    {
+    }
+
+    ~CWeakTarget()
+    {
+        m_pDestroyed->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Initialize() {}
+
+    GEMMETHOD_(int, Value)() final
+    {
+        return 7;
+    }
+};
+
+using CWeakTargetImpl = Gem::TGenericImpl<CWeakTarget, Gem::WeakReferenceThreadModel>;
+
+GEM_TEST(Weak_ResolveFailsAfterLastRelease)
+{
+    std::atomic<int> destroyed{0};
+    Gem::TGemPtr<CWeakTarget> pObject;
+    GEM_CHECK(Gem::Succeeded(CWeakTargetImpl::Create(&pObject, &destroyed)));
+    Gem::TGemWeakPtr<XWeakTarget> pWeak(pObject);
+    GEM_CHECK(pWeak.Get() != nullptr);
+
+    {
+        // The count moved into the side block is still the object's count
+        Gem::TGemPtr<XWeakTarget> pStrong = pWeak.Resolve();
+        GEM_CHECK(pStrong && pStrong->Value() == 7);
+        GEM_CHECK(pObject->AddRef() == 3);
+        GEM_CHECK(pObject->Release() == 2);
+    }
+
+    pObject = nullptr;
+    GEM_CHECK(destroyed.load() == 1);
+    GEM_CHECK(!pWeak.Resolve());
+}
+
+GEM_TEST(Weak_ResolveRacesFinalRelease)
+{
+    constexpr int ThreadCount = 4;
+    constexpr int Rounds = 500;
+
+    for (int round = 0; round < Rounds; ++round)
+    {
+        std::atomic<int> destroyed{0};
+        Gem::TGemPtr<CWeakTarget> pObject;
+        GEM_CHECK(Gem::Succeeded(CWeakTargetImpl::Create(&pObject, &destroyed)));
+        Gem::TGemWeakPtr<XWeakTarget> pWeak(pObject);
+
+        std::atomic<bool> start{false};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < ThreadCount; ++t)
+        {
+            threads.emplace_back([&]()
+            {
+                while (!start.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                // Once Resolve fails it must keep failing; while it succeeds the object is alive
+                while (Gem::TGemPtr<XWeakTarget> pStrong = pWeak.Resolve())
+                {
+                    GEM_CHECK(destroyed.load() == 0);
+                    GEM_CHECK(pStrong->Value() == 7);
+                }
+
+                GEM_CHECK(!pWeak.Resolve());
+            });
+        }
+
+        start.store(true, std::memory_order_release);
+        pObject = nullptr;
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        GEM_CHECK(destroyed.load() == 1);
+    }
+}
+
+GEM_TEST(Weak_BlockOutlivesObject)
+{
+    std::atomic<int> destroyed{0};
+    Gem::TGemPtr<CWeakTarget> pObject;
+    GEM_CHECK(Gem::Succeeded(CWeakTargetImpl::Create(&pObject, &destroyed)));
+
+    Gem::TGemPtr<Gem::XWeakReferenceSource> pSource;
+    GEM_CHECK(Gem::Succeeded(pObject->QueryInterface(GEM_IID_PPV_ARGS(&pSource))));
+    Gem::TGemPtr<Gem::XWeakReference> pWeakRef;
+    GEM_CHECK(pSource && Gem::Succeeded(pSource->GetWeakReference(&pWeakRef)));
+    pSource = nullptr;
+
+    // Later requests hand out the same block
+    Gem::TGemWeakPtr<XWeakTarget> pWeak(pObject);
+    GEM_CHECK(pWeak.Get() == pWeakRef.Get());
+
+    pObject = nullptr;
+    GEM_CHECK(destroyed.load() == 1);
+
+    // The block is still usable after the object is gone
+    Gem::TGemPtr<Gem::XWeakReference> pQueried;
+    GEM_CHECK(Gem::Succeeded(pWeakRef->QueryInterface(GEM_IID_PPV_ARGS(&pQueried))));
+    GEM_CHECK(pQueried.Get() == pWeakRef.Get());
+
+    Gem::TGemPtr<XWeakTarget> pResolved;
+    GEM_CHECK(pWeakRef->Resolve(GEM_IID_PPV_ARGS(&pResolved)) == Gem::Result::Success);
+    GEM_CHECK(!pResolved);
+
+    // The last weak reference frees the block (checked by sanitizer builds)
+    pQueried = nullptr;
+    pWeak.Reset();
+    pWeakRef = nullptr;
+}
+
+GEM_TEST(Weak_ObjectOutlivesBlockReferences)
+{
+    std::atomic<int> destroyed{0};
+    Gem::TGemPtr<CWeakTarget> pObject;
+    GEM_CHECK(Gem::Succeeded(CWeakTargetImpl::Create(&pObject, &destroyed)));
+
+    {
+        Gem::TGemWeakPtr<XWeakTarget> pWeak(pObject);
+        GEM_CHECK(pWeak.Resolve().Get() == static_cast<XWeakTarget *>(pObject.Get()));
+    }
+
+    // The object's own hold keeps the block until it is destroyed
+    GEM_CHECK(pObject->AddRef() == 2);
+    GEM_CHECK(pObject->Release() == 1);
+    pObject = nullptr;
+    GEM_CHECK(destroyed.load() == 1);
+}
+}
@@ -0,0 +1,110 @@
+//================================================================================================
+// GemPluginScan - builds and inspects plugin manifests
+//
+// Writes a manifest listing the classes each module provides. If the manifest already exists,
+// modules unchanged since it was written are copied from it, and only new or modified modules
+// are loaded to read their class maps.
+//
+//     GemPluginScan <manifest> <module>...
+//     GemPluginScan <manifest> --list
+//
+// Modules that fail to scan are left out of the manifest and reported; the exit code is then 1.
+//================================================================================================
+
+#include <GemPluginManifest.hpp>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+int Usage(const char *program)
+{
+    std::fprintf(stderr, "Usage: %s <manifest> <module>...\n       %s <manifest> --list\n", program, program);
+    return 2;
+}
+
+int List(const char *path)
+{
+    Gem::PluginManifest manifest;
+    Gem::Result result = manifest.Open(path);
+    if (Gem::Failed(result))
+    {
+        std::fprintf(stderr, "Cannot open %s: %s\n", path, Gem::GemResultString(result));
+        return 1;
+    }
+
+    for (const Gem::PluginManifestModule &module : manifest.Modules())
+    {
+        std::printf("%s%s\n", manifest.Path(module), manifest.IsCurrent(module) ? "" : " (stale)");
+        std::printf("    size %" PRIu64 ", hash 0x%016" PRIx64 "\n", module.FileSize, module.ContentHash);
+        for (const Gem::PluginManifestClass &manifestClass : manifest.Classes(module))
+        {
+            std::printf("    class 0x%016" PRIx64 "\n", manifestClass.ClassId);
+            for (uint64_t iid : manifest.InterfaceIds(manifestClass))
+            {
+                std::printf("        interface 0x%016" PRIx64 "\n", iid);
+            }
+        }
+
+        for (uint64_t clsid : manifest.RequiredClassIds(module))
+        {
+            std::printf("    requires 0x%016" PRIx64 "\n", clsid);
+        }
+    }
+
+    return 0;
+}
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        return Usage(argv[0]);
+    }
+
+    const char *manifestPath = argv[1];
+    if (std::strcmp(argv[2], "--list") == 0)
+    {
+        return argc == 3 ? List(manifestPath) : Usage(argv[0]);
+    }
+
+    // A missing or unreadable previous manifest just means every module is scanned
+    Gem::PluginManifest previous;
+    previous.Open(manifestPath);
+
+    Gem::PluginManifestBuilder builder;
+    size_t counts[3] = {};
+    size_t failed = 0;
+    for (int i = 2; i < argc; ++i)
+    {
+        Gem::PluginManifestBuilder::Source source;
+        Gem::Result result = builder.AddModule(argv[i], &previous, &source);
+        if (Gem::Failed(result))
+        {
+            std::fprintf(stderr, "Cannot scan %s: %s\n", argv[i], Gem::GemResultString(result));
+            ++failed;
+            continue;
+        }
+
+        ++counts[static_cast<size_t>(source)];
+    }
+
+    previous.Close();
+
+    Gem::Result result = builder.Write(manifestPath);
+    if (Gem::Failed(result))
+    {
+        std::fprintf(stderr, "Cannot write %s: %s\n", manifestPath, Gem::GemResultString(result));
+        return 1;
+    }
+
+    std::printf("%s: %zu reused, %zu rehashed, %zu scanned, %zu failed\n", manifestPath,
+        counts[static_cast<size_t>(Gem::PluginManifestBuilder::Source::Reused)],
+        counts[static_cast<size_t>(Gem::PluginManifestBuilder::Source::Rehashed)],
+        counts[static_cast<size_t>(Gem::PluginManifestBuilder::Source::Scanned)],
+        failed);
+    return failed == 0 ? 0 : 1;
+}
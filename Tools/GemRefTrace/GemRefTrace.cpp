@@ -0,0 +1,276 @@
+//================================================================================================
+// GemRefTrace - offline analysis of RefCountTracer dumps
+//
+// Merges the per-thread buffers by timestamp and replays each object's operations. A Release is
+// paired with the most recent unpaired AddRef; what remains unpaired is reported per object and
+// grouped by call site.
+//
+//     GemRefTrace trace.bin [--all]
+//
+// --all also prints objects whose operations all pair up. Return addresses are printed raw;
+// resolve them with addr2line -f -C -e <binary> (subtracting the load address for PIE).
+//================================================================================================
+
+#include <GemRefTrace.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Event
+{
+    Gem::RefTraceRecord Record;
+    uint32_t ThreadIndex;
+};
+
+// One lifetime of an object: from the first AddRef after creation to its Destroy record, or the
+// Release that returned 0. Addresses are reused, so one address can have several lifetimes.
+struct Lifetime
+{
+    uint64_t Object = 0;
+    uint32_t ClassIndex = 0;
+    bool Complete = false;      // History starts at creation (first AddRef returned 1)
+    bool Destroyed = false;
+    uint32_t LastCount = 0;
+    size_t AddRefs = 0;
+    size_t Releases = 0;
+    size_t Queries = 0;
+    std::vector<const Event *> Unpaired;
+    std::vector<const Event *> UnpairedReleases;
+};
+
+bool Read(std::FILE *pFile, void *pData, size_t size)
+{
+    return std::fread(pData, 1, size, pFile) == size;
+}
+
+bool Load(const char *path, std::vector<std::string> &classes, std::vector<Event> &events)
+{
+    std::FILE *pFile = std::fopen(path, "rb");
+    if (!pFile)
+    {
+        std::fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    Gem::RefTraceFileHeader header;
+    bool ok = Read(pFile, &header, sizeof(header)) &&
+        std::memcmp(header.Magic, Gem::RefTraceFileHeader::ExpectedMagic, sizeof(header.Magic)) == 0 &&
+        header.Version >= 1 && header.Version <= Gem::RefTraceFileHeader::CurrentVersion;
+    if (!ok)
+    {
+        std::fprintf(stderr, "%s is not a GeM reference count trace\n", path);
+        std::fclose(pFile);
+        return false;
+    }
+
+    for (uint32_t i = 0; ok && i < header.ClassCount; ++i)
+    {
+        uint32_t length = 0;
+        ok = Read(pFile, &length, sizeof(length));
+        std::string name(ok ? length : 0, '\0');
+        ok = ok && Read(pFile, name.data(), length);
+        classes.push_back(name);
+    }
+
+    for (uint32_t i = 0; ok && i < header.BufferCount; ++i)
+    {
+        uint32_t bufferHeader[2];
+        uint64_t count = 0;
+        ok = Read(pFile, bufferHeader, sizeof(bufferHeader)) && Read(pFile, &count, sizeof(count));
+        for (uint64_t j = 0; ok && j < count; ++j)
+        {
+            Event event;
+            event.ThreadIndex = bufferHeader[0];
+            ok = Read(pFile, &event.Record, sizeof(event.Record));
+            events.push_back(event);
+        }
+    }
+
+    std::fclose(pFile);
+    if (!ok)
+    {
+        std::fprintf(stderr, "%s is truncated\n", path);
+    }
+    return ok;
+}
+
+const char *OpName(uint8_t op)
+{
+    switch (static_cast<Gem::RefTraceOp>(op))
+    {
+    case Gem::RefTraceOp::AddRef:
+        return "AddRef";
+    case Gem::RefTraceOp::Release:
+        return "Release";
+    case Gem::RefTraceOp::QueryInterface:
+        return "QueryInterface";
+    case Gem::RefTraceOp::Destroy:
+        return "Destroy";
+    }
+    return "?";
+}
+
+void PrintEvent(const char *prefix, const Event &event, uint64_t start)
+{
+    const Gem::RefTraceRecord &record = event.Record;
+    std::printf("    %-9s %-14s t=%12.3fus thread %3u count %4u from 0x%" PRIx64 "\n", prefix, OpName(record.Op),
+        static_cast<double>(record.Timestamp - start) / 1000.0, event.ThreadIndex, record.Count, record.ReturnAddress);
+}
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    bool printAll = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--all") == 0)
+        {
+            printAll = true;
+        }
+        else if (argv[i][0] == '-' || path)
+        {
+            std::fprintf(stderr, "Usage: %s <trace> [--all]\n", argv[0]);
+            return 2;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    if (!path)
+    {
+        std::fprintf(stderr, "Usage: %s <trace> [--all]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> classes;
+    std::vector<Event> events;
+    if (!Load(path, classes, events))
+    {
+        return 1;
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b)
+    {
+        return a.Record.Timestamp < b.Record.Timestamp;
+    });
+    uint64_t start = events.empty() ? 0 : events.front().Record.Timestamp;
+
+    std::vector<Lifetime> lifetimes;
+    std::map<uint64_t, size_t> current;     // Object address -> index of its open lifetime
+    for (const Event &event : events)
+    {
+        const Gem::RefTraceRecord &record = event.Record;
+        auto found = current.find(record.Object);
+        if (record.Op == static_cast<uint8_t>(Gem::RefTraceOp::Destroy))
+        {
+            // The Release that returned 0, if there was one, has already ended the lifetime
+            if (found != current.end())
+            {
+                lifetimes[found->second].Destroyed = true;
+                current.erase(found);
+            }
+            continue;
+        }
+
+        if (found == current.end())
+        {
+            Lifetime lifetime;
+            lifetime.Object = record.Object;
+            lifetime.ClassIndex = record.ClassIndex;
+            lifetime.Complete = record.Op == static_cast<uint8_t>(Gem::RefTraceOp::AddRef) && record.Count == 1;
+            lifetimes.push_back(lifetime);
+            found = current.emplace(record.Object, lifetimes.size() - 1).first;
+        }
+
+        Lifetime &lifetime = lifetimes[found->second];
+        switch (static_cast<Gem::RefTraceOp>(record.Op))
+        {
+        case Gem::RefTraceOp::AddRef:
+            ++lifetime.AddRefs;
+            lifetime.LastCount = record.Count;
+            lifetime.Unpaired.push_back(&event);
+            break;
+
+        case Gem::RefTraceOp::Release:
+            ++lifetime.Releases;
+            lifetime.LastCount = record.Count;
+            if (lifetime.Unpaired.empty())
+            {
+                lifetime.UnpairedReleases.push_back(&event);
+            }
+            else
+            {
+                lifetime.Unpaired.pop_back();
+            }
+
+            if (record.Count == 0)
+            {
+                lifetime.Destroyed = true;
+                current.erase(found);
+            }
+            break;
+
+        case Gem::RefTraceOp::QueryInterface:
+            ++lifetime.Queries;
+            break;
+
+        case Gem::RefTraceOp::Destroy:
+            break;
+        }
+    }
+
+    std::map<uint64_t, size_t> unpairedSites;
+    size_t suspicious = 0;
+    for (const Lifetime &lifetime : lifetimes)
+    {
+        // References held from before the trace started explain unpaired Releases
+        bool balanced = lifetime.Unpaired.empty() && (lifetime.UnpairedReleases.empty() || !lifetime.Complete);
+        suspicious += balanced ? 0 : 1;
+        if (balanced && !printAll)
+        {
+            continue;
+        }
+
+        const char *className = lifetime.ClassIndex < classes.size() ? classes[lifetime.ClassIndex].c_str() : "?";
+        std::printf("Object 0x%" PRIx64 " (%s): %s, count %u, %zu AddRef, %zu Release, %zu QueryInterface%s\n",
+            lifetime.Object, className, lifetime.Destroyed ? "destroyed" : "alive", lifetime.LastCount,
+            lifetime.AddRefs, lifetime.Releases, lifetime.Queries, lifetime.Complete ? "" : " (trace starts mid-life)");
+
+        for (const Event *pEvent : lifetime.Unpaired)
+        {
+            PrintEvent("unpaired", *pEvent, start);
+            ++unpairedSites[pEvent->Record.ReturnAddress];
+        }
+
+        for (const Event *pEvent : lifetime.UnpairedReleases)
+        {
+            PrintEvent("unpaired", *pEvent, start);
+        }
+    }
+
+    std::printf("\n%zu records, %zu object lifetimes, %zu with unpaired operations\n", events.size(), lifetimes.size(), suspicious);
+
+    if (!unpairedSites.empty())
+    {
+        std::vector<std::pair<uint64_t, size_t>> sites(unpairedSites.begin(), unpairedSites.end());
+        std::sort(sites.begin(), sites.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+
+        std::printf("\nUnpaired AddRef call sites:\n");
+        for (const auto &site : sites)
+        {
+            std::printf("    0x%" PRIx64 " %8zu\n", site.first, site.second);
+        }
+    }
+
+    return suspicious == 0 ? 0 : 3;
+}